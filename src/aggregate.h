@@ -273,6 +273,7 @@ public:
 
     bool isBaseInfoComplete();
     Dsymbol *search(Loc, Identifier *ident, int flags = IgnoreNone);
+    void addSpellings(Speller *sp);
     ClassDeclaration *searchBase(Loc, Identifier *ident);
     bool isFuncHidden(FuncDeclaration *fd);
     FuncDeclaration *findFunc(Identifier *ident, TypeFunction *tf);
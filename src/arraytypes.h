@@ -68,6 +68,8 @@ typedef Array<class GotoStatement *> GotoStatements;
 
 typedef Array<class TemplateInstance *> TemplateInstances;
 
+typedef Array<class TemplateDeclaration *> TemplateDeclarations;
+
 typedef Array<struct block *> Blocks;
 
 typedef Array<struct Symbol *> Symbols;
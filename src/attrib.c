@@ -841,6 +841,8 @@ void PragmaDeclaration::semantic(Scope *sc)
                     errorSupplemental(loc, "while evaluating pragma(msg, %s)", (*args)[i]->toChars());
                     return;
                 }
+                if (global.quiet)
+                    continue;           // another -j job prints it
                 StringExp *se = e->toStringExp();
                 if (se)
                 {
@@ -850,7 +852,8 @@ void PragmaDeclaration::semantic(Scope *sc)
                 else
                     fprintf(stderr, "%s", e->toChars());
             }
-            fprintf(stderr, "\n");
+            if (!global.quiet)
+                fprintf(stderr, "\n");
         }
         goto Lnodecl;
     }
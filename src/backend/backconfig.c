@@ -49,7 +49,9 @@ void out_config_init(
                         // 1: D
                         // 2: fake it with C symbolic debug info
         bool alwaysframe,       // always create standard function frame
-        bool stackstomp         // add stack stomping code
+        bool stackstomp,        // add stack stomping code
+        bool regcolor,          // colour all register candidates in one pass
+        int scheduler           // TARGET_xxx to schedule 64 bit code for, 0 for none
         )
 {
 #if MARS
@@ -59,6 +61,8 @@ void out_config_init(
     {   config.target_cpu = TARGET_PentiumPro;
         config.target_scheduler = config.target_cpu;
     }
+    if (scheduler)
+        config.target_scheduler = scheduler;
     config.fulltypes = CVNONE;
     config.fpxmmregs = FALSE;
     config.inline8087 = 1;
@@ -226,6 +230,8 @@ void out_config_init(
         config.flags |= CFGalwaysframe;
     if (stackstomp)
         config.flags2 |= CFG2stomp;
+    if (regcolor)
+        config.flags4 |= CFG4regcolor;
 
     ph_init();
     block_init();
@@ -738,13 +738,6 @@ void cgreg_unregister(regm_t conflict)
     }
 }
 
-/******************************************
- * Do register assignments.
- * Returns:
- *      !=0     redo code generation
- *      0       no more register assignments
- */
-
 struct Reg              // data for trial register assignment
 {
     Symbol *sym;
@@ -753,6 +746,144 @@ struct Reg              // data for trial register assignment
     int benefit;
 };
 
+/******************************************
+ * Find the register, or register pair, it would most benefit
+ * symbol s to be put in.
+ * Returns:
+ *      true    and the register in *u, and the blocks s would be in it
+ *              in v
+ *      false   if s is not a candidate, or would not benefit
+ */
+
+STATIC bool cgreg_bestreg(Symbol *s, Symbol *retsym, regm_t regparams, Reg *u, vec_t v)
+{
+    unsigned dst_integer_reg;
+    unsigned dst_float_reg;
+    cgreg_dst_regs(&dst_integer_reg, &dst_float_reg);
+    regm_t dst_integer_mask = mask[dst_integer_reg];
+    regm_t dst_float_mask = mask[dst_float_reg];
+
+    u->sym = s;
+    if (!(s->Sflags & GTregcand) ||
+        s->Sflags & SFLspill ||
+        // Keep trying to reassign retsym into destination register
+        (s->Sfl == FLreg && !(s == retsym && s->Sregm != dst_integer_mask && s->Sregm != dst_float_mask))
+       )
+    {
+        #ifdef DEBUG
+        if (debugr)
+        if (s->Sfl == FLreg)
+            printf("symbol '%s' is in reg %s\n",s->Sident,regm_str(s->Sregm));
+        else if (s->Sflags & SFLspill)
+            printf("symbol '%s' spilled in reg %s\n",s->Sident,regm_str(s->Sregm));
+        else if (!(s->Sflags & GTregcand))
+            printf("symbol '%s' is not a reg candidate\n",s->Sident);
+        else
+            printf("symbol '%s' is not a candidate\n",s->Sident);
+        #endif
+        return false;
+    }
+
+    tym_t ty = s->ty();
+
+    #ifdef DEBUG
+        if (debugr)
+        {   printf("symbol '%3s', ty x%x weight x%x\n   ",
+            s->Sident,ty,s->Sweight);
+            vec_println(s->Srange);
+        }
+    #endif
+
+    // Select sequence of registers to try to map s onto
+    char *pseq;                     // sequence to try for LSW
+    char *pseqmsw = NULL;           // sequence to try for MSW, NULL if none
+    cgreg_set_priorities(ty, &pseq, &pseqmsw);
+
+    u->benefit = 0;
+    for (int i = 0; pseq[i] != NOREG; i++)
+    {
+        unsigned reg = pseq[i];
+
+        // Symbols used as return values should only be mapped into return value registers
+        if (s == retsym && !(reg == dst_integer_reg || reg == dst_float_reg))
+            continue;
+
+        // If BP isn't available, can't assign to it
+        if (reg == BP && !(allregs & mBP))
+            continue;
+
+#if 0 && TARGET_LINUX
+        // Need EBX for static pointer
+        if (reg == BX && !(allregs & mBX))
+            continue;
+#endif
+        /* Don't assign register parameter to another register parameter
+         */
+        if ((s->Sclass == SCfastpar || s->Sclass == SCshadowreg) &&
+            mask[reg] & regparams &&
+            reg != s->Spreg)
+            continue;
+
+        if (s->Sflags & GTbyte &&
+            !(mask[reg] & BYTEREGS))
+                continue;
+
+        int benefit = cgreg_benefit(s,reg,retsym);
+
+        #ifdef DEBUG
+        if (debugr)
+        {   printf(" %s",regstring[reg]);
+            vec_print(regrange[reg]);
+            printf(" %d\n",benefit);
+        }
+        #endif
+
+        if (benefit > u->benefit)
+        {   // successful assigning of lsw
+            unsigned regmsw = NOREG;
+
+            // Now assign MSW
+            if (pseqmsw)
+            {
+                for (unsigned regj = 0; 1; regj++)
+                {
+                    regmsw = pseqmsw[regj];
+                    if (regmsw == NOREG)
+                        goto Ltried;                // tried and failed to assign MSW
+                    if (regmsw == reg)              // can't assign msw and lsw to same reg
+                        continue;
+                    if ((s->Sclass == SCfastpar || s->Sclass == SCshadowreg) &&
+                        mask[regmsw] & regparams &&
+                        regmsw != s->Spreg2)
+                        continue;
+                    #ifdef DEBUG
+                    if (debugr)
+                    {   printf(".%s",regstring[regmsw]);
+                        vec_println(regrange[regmsw]);
+                    }
+                    #endif
+                    if (vec_disjoint(s->Slvreg,regrange[regmsw]))
+                        break;
+                }
+            }
+            vec_copy(v,s->Slvreg);
+            u->benefit = benefit;
+            u->reglsw = reg;
+            u->regmsw = regmsw;
+        }
+Ltried:     ;
+    }
+
+    return u->benefit > 0;
+}
+
+/******************************************
+ * Do register assignments.
+ * Returns:
+ *      !=0     redo code generation
+ *      0       no more register assignments
+ */
+
 int cgreg_assign(Symbol *retsym)
 {
     int flag = FALSE;                   // assume no changes
@@ -815,12 +946,6 @@ int cgreg_assign(Symbol *retsym)
 
     vec_t v = vec_calloc(dfotop);
 
-    unsigned dst_integer_reg;
-    unsigned dst_float_reg;
-    cgreg_dst_regs(&dst_integer_reg, &dst_float_reg);
-    regm_t dst_integer_mask = mask[dst_integer_reg];
-    regm_t dst_float_mask = mask[dst_float_reg];
-
     /* Find all the parameters passed as registers
      */
     regm_t regparams = 0;
@@ -830,138 +955,53 @@ int cgreg_assign(Symbol *retsym)
             regparams |= s->Spregm();
     }
 
-    // Find symbol t, which is the most 'deserving' symbol that should be
-    // placed into a register.
-    Reg t;
-    t.sym = NULL;
-    t.benefit = 0;
-    for (size_t si = 0; si < globsym.top; si++)
-    {   symbol *s = globsym.tab[si];
-
-        Reg u;
-        u.sym = s;
-        if (!(s->Sflags & GTregcand) ||
-            s->Sflags & SFLspill ||
-            // Keep trying to reassign retsym into destination register
-            (s->Sfl == FLreg && !(s == retsym && s->Sregm != dst_integer_mask && s->Sregm != dst_float_mask))
-           )
-        {
-            #ifdef DEBUG
-            if (debugr)
-            if (s->Sfl == FLreg)
-                printf("symbol '%s' is in reg %s\n",s->Sident,regm_str(s->Sregm));
-            else if (s->Sflags & SFLspill)
-                printf("symbol '%s' spilled in reg %s\n",s->Sident,regm_str(s->Sregm));
-            else if (!(s->Sflags & GTregcand))
-                printf("symbol '%s' is not a reg candidate\n",s->Sident);
-            else
-                printf("symbol '%s' is not a candidate\n",s->Sident);
-            #endif
-            continue;
-        }
-
-        tym_t ty = s->ty();
-
-        #ifdef DEBUG
-            if (debugr)
-            {   printf("symbol '%3s', ty x%x weight x%x\n   ",
-                s->Sident,ty,s->Sweight);
-                vec_println(s->Srange);
-            }
-        #endif
-
-        // Select sequence of registers to try to map s onto
-        char *pseq;                     // sequence to try for LSW
-        char *pseqmsw = NULL;           // sequence to try for MSW, NULL if none
-        cgreg_set_priorities(ty, &pseq, &pseqmsw);
-
-        u.benefit = 0;
-        for (int i = 0; pseq[i] != NOREG; i++)
-        {
-            unsigned reg = pseq[i];
-
-            // Symbols used as return values should only be mapped into return value registers
-            if (s == retsym && !(reg == dst_integer_reg || reg == dst_float_reg))
-                continue;
-
-            // If BP isn't available, can't assign to it
-            if (reg == BP && !(allregs & mBP))
-                continue;
-
-#if 0 && TARGET_LINUX
-            // Need EBX for static pointer
-            if (reg == BX && !(allregs & mBX))
-                continue;
-#endif
-            /* Don't assign register parameter to another register parameter
-             */
-            if ((s->Sclass == SCfastpar || s->Sclass == SCshadowreg) &&
-                mask[reg] & regparams &&
-                reg != s->Spreg)
-                continue;
-
-            if (s->Sflags & GTbyte &&
-                !(mask[reg] & BYTEREGS))
-                    continue;
-
-            int benefit = cgreg_benefit(s,reg,retsym);
+    if (config.flags4 & CFG4regcolor)
+    {
+        /* Colour all the candidates in this pass, heaviest first, each
+         * into the register that benefits it most given the ones already
+         * taken. Where the register is taken in some of the blocks the
+         * candidate lives in, its live range is split and it is spilled
+         * in those blocks. Code generation then runs again only to find
+         * the registers that are left, instead of once per symbol.
+         */
+        Symbol **sorted = (Symbol **) util_calloc(globsym.top, sizeof(Symbol *));
+        memcpy(sorted, globsym.tab, globsym.top * sizeof(Symbol *));
+        qsort(sorted, globsym.top, sizeof(Symbol *), weight_compare);
+        for (size_t si = 0; si < globsym.top; si++)
+        {   Reg u;
 
-            #ifdef DEBUG
-            if (debugr)
-            {   printf(" %s",regstring[reg]);
-                vec_print(regrange[reg]);
-                printf(" %d\n",benefit);
+            if (cgreg_bestreg(sorted[si], retsym, regparams, &u, v))
+            {   vec_copy(u.sym->Slvreg,v);
+                cgreg_map(u.sym,u.regmsw,u.reglsw);
+                flag = TRUE;
             }
-            #endif
-
-            if (benefit > u.benefit)
-            {   // successful assigning of lsw
-                unsigned regmsw = NOREG;
+        }
+        util_free(sorted);
+    }
+    else
+    {
+        // Find symbol t, which is the most 'deserving' symbol that should be
+        // placed into a register.
+        Reg t;
+        t.sym = NULL;
+        t.benefit = 0;
+        for (size_t si = 0; si < globsym.top; si++)
+        {   Reg u;
 
-                // Now assign MSW
-                if (pseqmsw)
-                {
-                    for (unsigned regj = 0; 1; regj++)
-                    {
-                        regmsw = pseqmsw[regj];
-                        if (regmsw == NOREG)
-                            goto Ltried;                // tried and failed to assign MSW
-                        if (regmsw == reg)              // can't assign msw and lsw to same reg
-                            continue;
-                        if ((s->Sclass == SCfastpar || s->Sclass == SCshadowreg) &&
-                            mask[regmsw] & regparams &&
-                            regmsw != s->Spreg2)
-                            continue;
-                        #ifdef DEBUG
-                        if (debugr)
-                        {   printf(".%s",regstring[regmsw]);
-                            vec_println(regrange[regmsw]);
-                        }
-                        #endif
-                        if (vec_disjoint(s->Slvreg,regrange[regmsw]))
-                            break;
-                    }
-                }
-                vec_copy(v,s->Slvreg);
-                u.benefit = benefit;
-                u.reglsw = reg;
-                u.regmsw = regmsw;
+            if (cgreg_bestreg(globsym.tab[si], retsym, regparams, &u, v) &&
+                u.benefit > t.benefit)
+            {   t = u;
+                vec_copy(t.sym->Slvreg,v);
             }
-Ltried:     ;
         }
 
-        if (u.benefit > t.benefit)
-        {   t = u;
-            vec_copy(t.sym->Slvreg,v);
+        if (t.sym && t.benefit > 0)
+        {
+            cgreg_map(t.sym,t.regmsw,t.reglsw);
+            flag = TRUE;
         }
     }
 
-    if (t.sym && t.benefit > 0)
-    {
-        cgreg_map(t.sym,t.regmsw,t.reglsw);
-        flag = TRUE;
-    }
-
     /* See if any scratch registers have become available that we can use.
      * Scratch registers are cheaper, as they don't need save/restore.
      * All floating point registers are scratch registers, so no need
@@ -1006,7 +1046,9 @@ static int __cdecl weight_compare(const void *e1,const void *e2)
     psp1 = (Symbol **)e1;
     psp2 = (Symbol **)e2;
 
-    return (*psp2)->Sweight - (*psp1)->Sweight;
+    if ((*psp2)->Sweight != (*psp1)->Sweight)
+        return (*psp2)->Sweight - (*psp1)->Sweight;
+    return (*psp1)->Ssymnum - (*psp2)->Ssymnum;        // keep the order stable
 }
 
 
@@ -74,6 +74,7 @@ struct Cinfo
 
 code *simpleops(code *c,regm_t scratch);
 code *schedule(code *c,regm_t scratch);
+code *schedule64(code *c);
 code *peephole(code *c,regm_t scratch);
 
 /*****************************************
@@ -105,6 +106,12 @@ void cgsched_block(block* b)
         config.target_cpu >= TARGET_Pentium &&
         b->BC != BCasm)
     {
+        if (I64 && config.target_scheduler >= TARGET_Skylake)
+        {
+            b->Bcode = schedule64(b->Bcode);
+            return;
+        }
+
         regm_t scratch = allregs;
 
         scratch &= ~(b->Bregcon.used | b->Bregcon.params | mfuncreg);
@@ -2743,6 +2750,898 @@ code *schedule(code *c,regm_t scratch)
     return cresult;
 }
 
+/**************************************************************************
+ * List scheduler for 64 bit code.
+ *
+ * Processors since the Pentium Pro reorder instructions themselves, but
+ * only the few they have decoded, and they start no more a clock than
+ * they have free units for. Within each run of instructions free of
+ * jumps, calls, jump targets and stack adjustments, start the ones at
+ * the heads of the longest chains of latencies first and interleave the
+ * ones that use different units, going by a table of the latencies and
+ * units of the processor selected with -mcpu. Instructions not
+ * understood here are left where they are, and end the run.
+ */
+
+// Execution units
+enum
+{
+    XUalu,              // integer add, logic, move, lea
+    XUshift,            // shifts, rotates, bit tests
+    XUimul,             // integer multiply, bit scans
+    XUidiv,             // integer divide
+    XUfadd,             // floating add, subtract, compare, min, max
+    XUfmul,             // floating and vector multiply
+    XUfdiv,             // floating divide and square root
+    XUvec,              // SSE moves, logic, shuffles and integer vector ops
+    XUcvt,              // conversions
+    XUload,             // loads
+    XUstore,            // stores
+    XUMAX
+};
+
+#define XUNITMAX        8               // most of one kind of unit
+
+struct XModel
+{
+    unsigned char issue;                // instructions started a clock
+    unsigned char units[XUMAX];         // number of each unit
+    unsigned char latency[XUMAX];       // clocks until its result can be used
+    unsigned char busy[XUMAX];          // clocks until it can start another
+};
+
+// From the instruction tables of Agner Fog and the optimization manuals
+static XModel skylake =
+{   4,
+    //  alu shift imul idiv fadd fmul fdiv  vec  cvt load store
+    {     4,    2,   1,   1,   2,   2,   1,   3,   2,   2,   1 },
+    {     1,    1,   3,  26,   4,   4,  14,   1,   5,   5,   1 },
+    {     1,    1,   1,   6,   1,   1,   4,   1,   1,   1,   1 },
+};
+
+static XModel zen =
+{   5,
+    {     4,    2,   1,   1,   2,   2,   1,   4,   2,   2,   1 },
+    {     1,    1,   3,  20,   3,   3,  13,   1,   4,   4,   1 },
+    {     1,    1,   1,  14,   1,   1,   5,   1,   1,   1,   1 },
+};
+
+// Registers and flags an instruction reads or writes
+#define XRreg(reg)      (1ULL << (reg))         // AX..R15
+#define XRxmm(reg)      (1ULL << (16 + (reg)))  // XMM0..XMM15
+#define XRflags         (1ULL << 32)
+
+// Struct where we gather information about an instruction for schedule64()
+struct Xinfo
+{
+    code *c;                    // the instruction
+    code *clast;                // last of the line numbers and NOPs after it
+    targ_ullong r;              // XRxxx read
+    targ_ullong w;              // XRxxx written
+    unsigned char unit;         // XUxxx it executes in
+    unsigned char mem;          // memory operand is
+        #define XMread  1       // read
+        #define XMwrite 2       // written
+    unsigned char size;         // bytes of memory referred to
+    unsigned char ea;           // how the memory is addressed
+        #define XEAunknown 0    // can't tell where it is
+        #define XEAreg  1       // disp[base + index * (1 << scale)]
+        #define XEAsym  2       // disp[sym]
+    unsigned char base;         // for XEAreg, base register or NOREG
+    unsigned char index;        // for XEAreg, index register or NOREG
+    unsigned char scale;
+    bool unambig;               // memory isn't referred to any other way
+    targ_llong disp;
+    Symbol *sym;                // for XEAsym
+};
+
+/******************************************
+ * Returns:
+ *      XRxxx for general register reg of a byte operation if byte
+ */
+
+STATIC targ_ullong xgpr(unsigned reg,bool byte,unsigned rex)
+{
+    if (byte && !rex && reg >= 4)
+        reg &= 3;                       // AH, CH, DH, BH
+    return XRreg(reg);
+}
+
+/******************************************
+ * Fill in the memory operand of x from c's modregrm and sib bytes.
+ */
+
+STATIC void getea64(Xinfo *x,code *c)
+{
+    unsigned rex = c->Irex;
+    unsigned mod = c->Irm >> 6;
+    unsigned rm = c->Irm & 7;
+
+    x->ea = XEAunknown;
+    x->base = NOREG;
+    x->index = NOREG;
+    if (rm == 4)
+    {   unsigned sib = c->Isib;
+        unsigned index = ((sib >> 3) & 7) | ((rex & REX_X) ? 8 : 0);
+        unsigned base = (sib & 7) | ((rex & REX_B) ? 8 : 0);
+
+        if (index != SP)
+        {   x->r |= XRreg(index);
+            x->index = index;
+            x->scale = sib >> 6;
+        }
+        if ((sib & 7) == 5 && mod == 0)
+            return;                     // disp32[index], no base
+        x->r |= XRreg(base);
+        x->base = base;
+    }
+    else if (rm == 5 && mod == 0)
+    {   // RIP relative
+        if (c->IFL1 == FLextern && !(c->Iflags & CFSEG))
+        {   x->ea = XEAsym;
+            x->sym = c->IEVsym1;
+            x->disp = (targ_llong)c->IEVoffset1;
+        }
+        return;
+    }
+    else
+    {   unsigned base = rm | ((rex & REX_B) ? 8 : 0);
+
+        x->r |= XRreg(base);
+        x->base = base;
+    }
+
+    if (c->Iflags & CFSEG)              // FS: of thread local storage
+        return;
+    switch (mod)
+    {
+        case 0:
+            x->disp = 0;
+            break;
+        case 1:
+            if (c->IFL1 != FLconst)
+                return;
+            x->disp = (signed char)c->IEVpointer1;
+            break;
+        case 2:
+            if (c->IFL1 != FLconst)
+                return;
+            x->disp = (int)c->IEVpointer1;
+            break;
+    }
+    x->ea = XEAreg;
+    x->unambig = (c->Iflags & CFunambig) != 0;
+}
+
+// How an instruction uses its operands
+#define URr     1               // reads the reg operand of modregrm
+#define URw     2               // writes it
+#define UEr     4               // reads the r/m operand
+#define UEw     8               // writes it
+#define UEa     0x10            // only computes the r/m address
+#define UFr     0x20            // reads the flags
+#define UFw     0x40            // writes the flags
+#define UB      0x80            // byte operands
+#define UEb     0x100           // byte r/m operand
+#define URx     0x200           // reg operand is an XMM register
+#define UEx     0x400           // r/m operand, if a register, is an XMM register
+#define Umov    0x800           // only moves r/m to reg, or reg to r/m
+
+/******************************************
+ * Fill in *x for instruction c.
+ * Returns:
+ *      false if c isn't understood, and has to stay where it is
+ */
+
+STATIC bool getinfo64(Xinfo *x,code *c)
+{
+    memset(x,0,sizeof(Xinfo));
+    x->c = c;
+    x->clast = c;
+    if (c->Iflags & (CFtarg | CFtarg2 | CFvolatile | CFvex | CFaddrsize | CFclassinit | CFswitch))
+        return false;
+
+    unsigned op = c->Iop;
+    unsigned rex = c->Irex;
+    unsigned mod = c->Irm >> 6;
+    unsigned ext = (c->Irm >> 3) & 7;   // opcode extension in reg field
+    unsigned reg = ext | ((rex & REX_R) ? 8 : 0);
+    unsigned rm = (c->Irm & 7) | ((rex & REX_B) ? 8 : 0);
+    unsigned sz = (rex & REX_W) ? 8 : (c->Iflags & CFopsize) ? 2 : 4;
+    unsigned use = 0;                   // Uxxx
+    unsigned unit = XUalu;
+    unsigned msize = 0;                 // size of memory operand if not sz
+
+    if (op < 0x40 && (op & 7) < 6)
+    {   // ADD, OR, ADC, SBB, AND, SUB, XOR, CMP
+        bool cmp = (op >> 3) == 7;
+
+        use = UFw;
+        if ((op >> 3) == 2 || (op >> 3) == 3)
+            use |= UFr;                 // ADC, SBB
+        switch (op & 7)
+        {
+            case 0:
+                use |= UB;
+            case 1:                     // op rm,reg
+                use |= URr | UEr | (cmp ? 0 : UEw);
+                break;
+            case 2:
+                use |= UB;
+            case 3:                     // op reg,rm
+                use |= URr | UEr | (cmp ? 0 : URw);
+                break;
+            case 4:
+            case 5:                     // op AL/EAX,imm
+                x->r |= XRreg(AX);
+                if (!cmp)
+                    x->w |= XRreg(AX);
+                break;
+        }
+    }
+    else if (op < 0x100)
+    {
+        switch (op)
+        {
+            case 0x63:                          // MOVSXD reg,rm
+                if (!(rex & REX_W))
+                    return false;
+                use = URw | UEr | Umov;
+                msize = 4;
+                break;
+
+            case 0x69:
+            case 0x6B:                          // IMUL reg,rm,imm
+                use = URw | UEr | UFw;
+                unit = XUimul;
+                break;
+
+            case 0x80:
+            case 0x81:
+            case 0x83:                          // Grp 1
+                use = UEr | UFw | (op == 0x80 ? UB : 0);
+                if (ext != 7)                   // not CMP
+                    use |= UEw;
+                if (ext == 2 || ext == 3)       // ADC, SBB
+                    use |= UFr;
+                break;
+
+            case 0x84:
+            case 0x85:                          // TEST rm,reg
+                use = URr | UEr | UFw | (op == 0x84 ? UB : 0);
+                break;
+
+            case 0x88:                          // MOV rm,reg
+                use = UB | URr | UEw | Umov;
+                break;
+            case 0x89:
+                use = URr | UEw | Umov;
+                break;
+            case 0x8A:                          // MOV reg,rm
+                use = UB | URw | UEr | Umov;
+                break;
+            case 0x8B:
+                use = URw | UEr | Umov;
+                break;
+
+            case 0x8D:                          // LEA
+                if (mod == 3)
+                    return false;
+                use = URw | UEa;
+                break;
+
+            case 0x98:                          // CBW, CWDE, CDQE
+                x->r |= XRreg(AX);
+                x->w |= XRreg(AX);
+                break;
+
+            case 0x99:                          // CWD, CDQ, CQO
+                x->r |= XRreg(AX) | XRreg(DX);
+                x->w |= XRreg(DX);
+                break;
+
+            case 0xA8:
+            case 0xA9:                          // TEST AL/EAX,imm
+                x->r |= XRreg(AX);
+                use = UFw;
+                break;
+
+            case 0xB0: case 0xB1: case 0xB2: case 0xB3:
+            case 0xB4: case 0xB5: case 0xB6: case 0xB7:         // MOV reg8,imm
+                x->r |= xgpr((op & 7) | ((rex & REX_B) ? 8 : 0),true,rex);
+                x->w |= xgpr((op & 7) | ((rex & REX_B) ? 8 : 0),true,rex);
+                break;
+
+            case 0xB8: case 0xB9: case 0xBA: case 0xBB:
+            case 0xBC: case 0xBD: case 0xBE: case 0xBF:         // MOV reg,imm
+                x->w |= XRreg((op & 7) | ((rex & REX_B) ? 8 : 0));
+                if (sz == 2)
+                    x->r |= XRreg((op & 7) | ((rex & REX_B) ? 8 : 0));
+                break;
+
+            case 0xC0:
+            case 0xC1:
+            case 0xD0:
+            case 0xD1:
+            case 0xD2:
+            case 0xD3:                          // Grp 2 shifts and rotates
+                use = UEr | UEw | UFw | ((op & 1) ? 0 : UB);
+                unit = XUshift;
+                if (op == 0xD2 || op == 0xD3)
+                {   x->r |= XRreg(CX);
+                    use |= UFr;                 // a count of 0 leaves the flags alone
+                }
+                else if (ext < 4)
+                    use |= UFr;                 // rotates leave some flags alone
+                else if ((op == 0xC0 || op == 0xC1) &&
+                         (c->IEV2.Vint & (sz == 8 ? 63 : 31)) == 0)
+                    use |= UFr;
+                break;
+
+            case 0xC6:
+            case 0xC7:                          // MOV rm,imm
+                if (ext != 0)
+                    return false;
+                use = UEw | Umov | (op == 0xC6 ? UB : 0);
+                break;
+
+            case 0xF6:
+            case 0xF7:                          // Grp 3
+            {   targ_ullong m = (op == 0xF6) ? XRreg(AX) : XRreg(AX) | XRreg(DX);
+
+                switch (ext)
+                {
+                    case 0:                     // TEST rm,imm
+                        use = UEr | UFw;
+                        break;
+                    case 2:                     // NOT
+                        use = UEr | UEw;
+                        break;
+                    case 3:                     // NEG
+                        use = UEr | UEw | UFw;
+                        break;
+                    case 4:
+                    case 5:                     // MUL, IMUL
+                        use = UEr | UFw;
+                        unit = XUimul;
+                        x->r |= (sz == 2) ? m : XRreg(AX);
+                        x->w |= m;
+                        break;
+                    case 6:
+                    case 7:                     // DIV, IDIV
+                        use = UEr | UFw;
+                        unit = XUidiv;
+                        x->r |= m;
+                        x->w |= m;
+                        break;
+                    default:
+                        return false;
+                }
+                if (op == 0xF6)
+                    use |= UB;
+                break;
+            }
+
+            case 0xFE:
+            case 0xFF:                          // INC, DEC
+                if (ext > 1)
+                    return false;               // calls, jumps and pushes
+                use = UEr | UEw | UFr | UFw | (op == 0xFE ? UB : 0);    // carry flag is left alone
+                break;
+
+            default:
+                return false;
+        }
+    }
+    else if ((op & 0xFF00) == 0x0F00 && (op >> 16) == 0 && (op & 0xF0) == 0x40)
+        use = URr | URw | UEr | UFr;            // CMOVcc
+    else if ((op & 0xFF00) == 0x0F00 && (op >> 16) == 0 && (op & 0xF0) == 0x90)
+        use = UEw | UFr | UB;                   // SETcc
+    else
+    {
+        switch (op)
+        {
+            case 0x0FAF:                        // IMUL reg,rm
+                use = URr | URw | UEr | UFw;
+                unit = XUimul;
+                break;
+
+            case 0x0FB6:
+            case 0x0FBE:                        // MOVZX, MOVSX reg,rm8
+                use = URw | UEr | UEb | Umov;
+                msize = 1;
+                break;
+            case 0x0FB7:
+            case 0x0FBF:                        // MOVZX, MOVSX reg,rm16
+                use = URw | UEr | Umov;
+                msize = 2;
+                break;
+
+            case 0x0FBC:
+            case 0x0FBD:                        // BSF, BSR leave reg alone if rm is 0
+                use = URr | URw | UEr | UFw;
+                unit = XUimul;
+                break;
+
+            case 0x0FA3:                        // BT rm,reg
+                if (mod != 3)
+                    return false;               // reg can index outside of rm
+                use = URr | UEr | UFw;
+                unit = XUshift;
+                break;
+
+            case 0x0FBA:                        // Grp 8 BT, BTS, BTR, BTC rm,imm
+                if (ext < 4)
+                    return false;
+                use = UEr | UFw | (ext == 4 ? 0 : UEw);
+                unit = XUshift;
+                break;
+
+            case 0xF20F10:                      // MOVSD reg,rm
+            case 0xF30F10:                      // MOVSS
+                use = URx | UEx | URw | UEr | Umov | (mod == 3 ? URr : 0);
+                msize = (op == 0xF20F10) ? 8 : 4;
+                unit = XUvec;
+                break;
+            case 0xF20F11:                      // MOVSD rm,reg
+            case 0xF30F11:                      // MOVSS
+                use = URx | UEx | URr | UEw | Umov | (mod == 3 ? UEr : 0);
+                msize = (op == 0xF20F11) ? 8 : 4;
+                unit = XUvec;
+                break;
+
+            case 0x0F10:                        // MOVUPS reg,rm
+            case 0x660F10:                      // MOVUPD
+            case 0x0F28:                        // MOVAPS
+            case 0x660F28:                      // MOVAPD
+            case 0x660F6F:                      // MOVDQA
+            case 0xF30F6F:                      // MOVDQU
+                use = URx | UEx | URw | UEr | Umov;
+                msize = 16;
+                unit = XUvec;
+                break;
+            case 0x0F11:                        // MOVUPS rm,reg
+            case 0x660F11:                      // MOVUPD
+            case 0x0F29:                        // MOVAPS
+            case 0x660F29:                      // MOVAPD
+            case 0x660F7F:                      // MOVDQA
+            case 0xF30F7F:                      // MOVDQU
+                use = URx | UEx | URr | UEw | Umov;
+                msize = 16;
+                unit = XUvec;
+                break;
+
+            case 0x660F6E:                      // MOVD, MOVQ xmm,rm
+                use = URx | URw | UEr | Umov;
+                msize = (rex & REX_W) ? 8 : 4;
+                unit = XUvec;
+                break;
+            case 0x660F7E:                      // MOVD, MOVQ rm,xmm
+                use = URx | URr | UEw | Umov;
+                msize = (rex & REX_W) ? 8 : 4;
+                unit = XUvec;
+                break;
+            case 0xF30F7E:                      // MOVQ xmm,xmm/m64
+                use = URx | UEx | URw | UEr | Umov;
+                msize = 8;
+                unit = XUvec;
+                break;
+            case 0x660FD6:                      // MOVQ xmm/m64,xmm
+                use = URx | UEx | URr | UEw | Umov;
+                msize = 8;
+                unit = XUvec;
+                break;
+
+            case 0xF20F2A:                      // CVTSI2SD
+            case 0xF30F2A:                      // CVTSI2SS
+                use = URx | URr | URw | UEr;
+                msize = (rex & REX_W) ? 8 : 4;
+                unit = XUcvt;
+                break;
+            case 0xF20F2C:                      // CVTTSD2SI
+            case 0xF20F2D:                      // CVTSD2SI
+            case 0xF30F2C:                      // CVTTSS2SI
+            case 0xF30F2D:                      // CVTSS2SI
+                use = UEx | URw | UEr;
+                msize = (op >> 16 == 0xF2) ? 8 : 4;
+                unit = XUcvt;
+                break;
+
+            case 0x0F2E:                        // UCOMISS
+            case 0x0F2F:                        // COMISS
+            case 0x660F2E:                      // UCOMISD
+            case 0x660F2F:                      // COMISD
+                use = URx | UEx | URr | UEr | UFw;
+                msize = (op >> 16 == 0x66) ? 8 : 4;
+                unit = XUfadd;
+                break;
+
+            case 0x0F51:   case 0x660F51:   case 0xF20F51:   case 0xF30F51:     // SQRT
+            case 0x0F5E:   case 0x660F5E:   case 0xF20F5E:   case 0xF30F5E:     // DIV
+                unit = XUfdiv;
+                goto Lfop;
+            case 0x0F59:   case 0x660F59:   case 0xF20F59:   case 0xF30F59:     // MUL
+                unit = XUfmul;
+                goto Lfop;
+            case 0x0F58:   case 0x660F58:   case 0xF20F58:   case 0xF30F58:     // ADD
+            case 0x0F5C:   case 0x660F5C:   case 0xF20F5C:   case 0xF30F5C:     // SUB
+            case 0x0F5D:   case 0x660F5D:   case 0xF20F5D:   case 0xF30F5D:     // MIN
+            case 0x0F5F:   case 0x660F5F:   case 0xF20F5F:   case 0xF30F5F:     // MAX
+            case 0x0FC2:   case 0x660FC2:   case 0xF20FC2:   case 0xF30FC2:     // CMP
+                unit = XUfadd;
+                goto Lfop;
+            case 0x0F5A:   case 0x660F5A:   case 0xF20F5A:   case 0xF30F5A:     // CVTPS2PD etc.
+            case 0x0F5B:   case 0x660F5B:   case 0xF30F5B:                      // CVTDQ2PS etc.
+            case 0x660FE6: case 0xF20FE6:   case 0xF30FE6:                      // CVTTPD2DQ etc.
+                unit = XUcvt;
+            Lfop:
+                use = URx | UEx | URr | URw | UEr;
+                msize = (op >> 16 == 0xF2) ? 8 : (op >> 16 == 0xF3) ? 4 : 16;
+                if (op == 0xF30F5A || op == 0xF30FE6)
+                    msize = 8;                  // CVTSS2SD, CVTDQ2PD
+                break;
+
+            case 0x0F54:   case 0x660F54:       // ANDPS, ANDPD
+            case 0x0F55:   case 0x660F55:       // ANDNPS, ANDNPD
+            case 0x0F56:   case 0x660F56:       // ORPS, ORPD
+            case 0x0F57:   case 0x660F57:       // XORPS, XORPD
+            case 0x0F14:   case 0x660F14:       // UNPCKLPS, UNPCKLPD
+            case 0x0F15:   case 0x660F15:       // UNPCKHPS, UNPCKHPD
+            case 0x0FC6:   case 0x660FC6:       // SHUFPS, SHUFPD
+            case 0x660FD4: case 0x660FFE: case 0x660FFD: case 0x660FFC:         // PADDQ, PADDD, PADDW, PADDB
+            case 0x660FFB: case 0x660FFA: case 0x660FF9: case 0x660FF8:         // PSUBQ, PSUBD, PSUBW, PSUBB
+            case 0x660FDB: case 0x660FDF: case 0x660FEB: case 0x660FEF:         // PAND, PANDN, POR, PXOR
+            case 0x660F74: case 0x660F75: case 0x660F76:                        // PCMPEQB, PCMPEQW, PCMPEQD
+            case 0x660F64: case 0x660F65: case 0x660F66:                        // PCMPGTB, PCMPGTW, PCMPGTD
+            case 0x660F60: case 0x660F61: case 0x660F62: case 0x660F6C:         // PUNPCKL
+            case 0x660F68: case 0x660F69: case 0x660F6A: case 0x660F6D:         // PUNPCKH
+                use = URx | UEx | URr | URw | UEr;
+                msize = 16;
+                unit = XUvec;
+                break;
+
+            case 0x660FD5:                      // PMULLW
+            case 0x660FF4:                      // PMULUDQ
+                use = URx | UEx | URr | URw | UEr;
+                msize = 16;
+                unit = XUfmul;
+                break;
+
+            case 0x660F70:                      // PSHUFD
+            case 0xF20F70:                      // PSHUFLW
+            case 0xF30F70:                      // PSHUFHW
+                use = URx | UEx | URw | UEr;
+                msize = 16;
+                unit = XUvec;
+                break;
+
+            case 0x660F71:
+            case 0x660F72:
+            case 0x660F73:                      // vector shifts by imm
+                if (mod != 3)
+                    return false;
+                use = UEx | UEr | UEw;
+                unit = XUvec;
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    if (use & UFr)
+        x->r |= XRflags;
+    if (use & UFw)
+        x->w |= XRflags;
+
+    if (use & (URr | URw))
+    {
+        targ_ullong m = (use & URx) ? XRxmm(reg) : xgpr(reg,(use & UB) != 0,rex);
+        if (use & URr)
+            x->r |= m;
+        if (use & URw)
+        {   x->w |= m;
+            if (!(use & URx) && (use & UB || sz == 2))
+                x->r |= m;              // rest of the register is left alone
+        }
+    }
+
+    if (use & (UEr | UEw | UEa))
+    {
+        if (mod == 3)
+        {
+            targ_ullong m = (use & UEx) ? XRxmm(rm) : xgpr(rm,(use & (UB | UEb)) != 0,rex);
+            if (use & UEr)
+                x->r |= m;
+            if (use & UEw)
+            {   x->w |= m;
+                if (!(use & UEx) && (use & UB || sz == 2))
+                    x->r |= m;
+            }
+        }
+        else
+        {
+            getea64(x,c);
+            if (use & UEr)
+                x->mem |= XMread;
+            if (use & UEw)
+                x->mem |= XMwrite;
+            x->size = msize ? msize : (use & (UB | UEb)) ? 1 : sz;
+        }
+    }
+
+    // The stack pointer changes only at the ends of the runs, so stores
+    // aren't moved into space that isn't allocated yet
+    if (x->w & XRreg(SP))
+        return false;
+
+    if (use & Umov && x->mem & XMread)
+        unit = XUload;
+    else if (use & Umov && x->mem & XMwrite)
+        unit = XUstore;
+    x->unit = unit;
+    return true;
+}
+
+/******************************************
+ * Returns:
+ *      true if the memory x1 and x2 refer to can't overlap
+ */
+
+STATIC bool xdisjoint(Xinfo *x1,Xinfo *x2)
+{
+    if (x1->ea == XEAsym && x2->ea == XEAsym)
+    {
+        if (x1->sym != x2->sym)
+            return strcmp(x1->sym->Sident,x2->sym->Sident) != 0;
+    }
+    else if (x1->ea == XEAreg && x2->ea == XEAreg)
+    {
+        if (x1->base != x2->base || x1->index != x2->index || x1->scale != x2->scale)
+        {
+            /* A local whose address isn't taken is only referred to directly
+             * off [RBP] or [RSP], which may point to the same place.
+             */
+            bool frame1 = x1->base == BP || x1->base == SP;
+            bool frame2 = x2->base == BP || x2->base == SP;
+            return (x1->unambig && !frame2) || (x2->unambig && !frame1);
+        }
+    }
+    else
+        return (x1->unambig && x2->ea == XEAsym) || (x2->unambig && x1->ea == XEAsym);
+
+    return x1->disp + x1->size <= x2->disp || x2->disp + x2->size <= x1->disp;
+}
+
+/******************************************
+ * Returns:
+ *      clocks until the result of x can be used
+ */
+
+STATIC int xlatency(XModel *m,Xinfo *x)
+{
+    int clocks = m->latency[x->unit];
+    if (x->mem & XMread && x->unit != XUload)
+        clocks += m->latency[XUload];
+    return clocks;
+}
+
+/******************************************
+ * Take the units x needs at clock.
+ * Returns:
+ *      false if they aren't all free
+ */
+
+STATIC bool xunits(XModel *m,int freeat[XUMAX][XUNITMAX],Xinfo *x,int clock,bool take)
+{
+    unsigned char need[3];
+    int nneed = 0;
+
+    need[nneed++] = x->unit;
+    if (x->mem & XMread && x->unit != XUload)
+        need[nneed++] = XUload;
+    if (x->mem & XMwrite && x->unit != XUstore)
+        need[nneed++] = XUstore;
+
+    for (int i = 0; i < nneed; i++)
+    {   unsigned u = need[i];
+        int k;
+
+        for (k = 0; k < m->units[u]; k++)
+        {
+            if (freeat[u][k] <= clock)
+                break;
+        }
+        if (k == m->units[u])
+            return false;
+        if (take)
+            freeat[u][k] = clock + m->busy[u];
+    }
+    return true;
+}
+
+#define XSCHEDMAX       64              // most instructions scheduled together
+
+/******************************************
+ * Reorder the n instructions x[] and append them to *pctail.
+ * Returns:
+ *      the new tail
+ */
+
+STATIC code **xschedule(Xinfo *x,int n,code **pctail)
+{
+    XModel *m = (config.target_scheduler == TARGET_Zen) ? &zen : &skylake;
+    signed char lat[XSCHEDMAX][XSCHEDMAX];      // clocks after i that j can start, -1 if any time
+    int flagsfrom[XSCHEDMAX];   // instruction whose flags it reads
+    bool flagslive[XSCHEDMAX];  // flags it writes are read
+    int height[XSCHEDMAX];      // clocks from its start to the end of the run
+    int npreds[XSCHEDMAX];      // instructions it has to wait for, -1 once scheduled
+    int earliest[XSCHEDMAX];    // clock it can start at
+    int order[XSCHEDMAX];
+    int freeat[XUMAX][XUNITMAX];
+
+    assert(n <= XSCHEDMAX);
+
+    /* Writes of the flags that nothing reads can go in any order,
+     * other than between a write that is read and its readers.
+     */
+    int lastw = -1;
+    for (int j = 0; j < n; j++)
+    {
+        flagsfrom[j] = -1;
+        flagslive[j] = false;
+        if (x[j].r & XRflags)
+        {   flagsfrom[j] = lastw;
+            if (lastw >= 0)
+                flagslive[lastw] = true;
+        }
+        if (x[j].w & XRflags)
+            lastw = j;
+    }
+    if (lastw >= 0)
+        flagslive[lastw] = true;        // may be read after the run
+
+    for (int j = 0; j < n; j++)
+    {
+        npreds[j] = 0;
+        earliest[j] = 0;
+        for (int i = 0; i < j; i++)
+        {   targ_ullong ri = x[i].r, wi = x[i].w;
+            targ_ullong rj = x[j].r, wj = x[j].w;
+            int l = -1;
+
+            if (wi & rj & ~XRflags || (rj & XRflags && flagsfrom[j] == i))
+                l = xlatency(m,&x[i]);
+            else if ((ri | wi) & wj & ~XRflags ||
+                     ri & wj & XRflags ||
+                     (wi & wj & XRflags && flagslive[j]))
+                l = 0;
+
+            if (x[i].mem && x[j].mem && (x[i].mem | x[j].mem) & XMwrite &&
+                !xdisjoint(&x[i],&x[j]))
+            {   int ml = (x[i].mem & XMwrite && x[j].mem & XMread) ? m->latency[XUload] : 0;
+                if (ml > l)
+                    l = ml;
+            }
+            lat[i][j] = l;
+            if (l >= 0)
+                npreds[j]++;
+        }
+    }
+
+    for (int i = n; i--; )
+    {   int h = xlatency(m,&x[i]);
+
+        for (int j = i + 1; j < n; j++)
+        {
+            if (lat[i][j] >= 0 && lat[i][j] + height[j] > h)
+                h = lat[i][j] + height[j];
+        }
+        height[i] = h;
+    }
+
+    memset(freeat,0,sizeof(freeat));
+    int norder = 0;
+    for (int clock = 0; norder < n; clock++)
+    {
+        for (int issued = 0; issued < m->issue; issued++)
+        {   int best = -1;
+
+            // Start the ready instruction with the longest way to go
+            for (int i = 0; i < n; i++)
+            {
+                if (npreds[i] || earliest[i] > clock)
+                    continue;
+                if (best >= 0 && height[i] <= height[best])
+                    continue;
+                if (!xunits(m,freeat,&x[i],clock,false))
+                    continue;
+                best = i;
+            }
+            if (best < 0)
+                break;
+
+            xunits(m,freeat,&x[best],clock,true);
+            order[norder++] = best;
+            npreds[best] = -1;
+            for (int j = best + 1; j < n; j++)
+            {
+                if (lat[best][j] >= 0)
+                {   npreds[j]--;
+                    if (clock + lat[best][j] > earliest[j])
+                        earliest[j] = clock + lat[best][j];
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < n; k++)
+    {   Xinfo *xi = &x[order[k]];
+
+#ifdef DEBUG
+        if (debugs) { printf("%2d: ",order[k]); xi->c->print(); }
+#endif
+        *pctail = xi->c;
+        pctail = &code_next(xi->clast);
+    }
+    return pctail;
+}
+
+/******************************
+ * Schedule 64 bit instructions for an out of order processor.
+ */
+
+code *schedule64(code *c)
+{
+    code *cresult = NULL;
+    code **pctail = &cresult;
+    Xinfo x[XSCHEDMAX];
+
+    while (c)
+    {
+        int n = 0;
+        while (c && n < XSCHEDMAX && getinfo64(&x[n],c))
+        {
+            // Line numbers and NOPs stay after the instruction they follow
+            code *cl = c;
+            while (code_next(cl) &&
+                   !(code_next(cl)->Iflags & (CFtarg | CFtarg2)) &&
+                   (code_next(cl)->Iop == NOP || code_next(cl)->Iop == (ESCAPE | ESClinnum)))
+                cl = code_next(cl);
+            x[n].clast = cl;
+            c = code_next(cl);
+            n++;
+        }
+        if (n)
+            pctail = xschedule(x,n,pctail);
+
+        if (c && n < XSCHEDMAX)
+        {   // c stays where it is, and so does what a prefix applies to
+            code *cl = c;
+            switch (c->Iop)
+            {
+                case 0xF0:                      // LOCK
+                case 0xF2:
+                case 0xF3:                      // REP
+                case 0x26:
+                case 0x36:
+                case 0x64:
+                case 0x65:                      // segment overrides
+                case 0x66:
+                case 0x67:
+                    if (code_next(c))
+                        cl = code_next(c);
+                    break;
+            }
+            *pctail = c;
+            pctail = &code_next(cl);
+            c = code_next(cl);
+        }
+    }
+    *pctail = NULL;
+    return cresult;
+}
+
 /**************************************************************************/
 
 /********************************************
@@ -1851,6 +1851,24 @@ elem *el_scancommas(elem *e)
     return e;
 }
 
+/***************************
+ * Count number of elems in the expression.
+ */
+
+int el_countNodes(elem *e)
+{   int nodes = 0;
+    while (1)
+    {
+        nodes++;
+        if (EBIN(e))
+            nodes += el_countNodes(e->E2);
+        else if (!EUNA(e))
+            break;
+        e = e->E1;
+    }
+    return nodes;
+}
+
 /***************************
  * Count number of commas in the expression.
  */
@@ -140,6 +140,7 @@ elem_p el_copytree(elem_p);
 void   el_replace_sym(elem *e,symbol *s1,symbol *s2);
 elem_p el_scancommas(elem_p);
 int el_countCommas(elem_p);
+int el_countNodes(elem_p);
 int el_sideeffect(elem_p);
 int el_depends(elem *ea,elem *eb);
 #if LONGLONG
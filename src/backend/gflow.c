@@ -54,6 +54,84 @@ STATIC void accumlv(vec_t GEN , vec_t KILL , elem *n);
 STATIC void accumvbe(vec_t GEN , vec_t KILL , elem *n);
 STATIC void accumrd(vec_t GEN , vec_t KILL , elem *n);
 STATIC void flowaecp(void);
+
+/* The kinds of dataflow problem solved, for flowstats[]                */
+
+enum { FLOWrd, FLOWae, FLOWcp, FLOWlv, FLOWvbe, FLOWmax };
+
+static const char *flowname[FLOWmax] = { "rd", "ae", "cp", "lv", "vbe" };
+
+/* The work done solving each kind of dataflow problem                  */
+
+static struct FlowStats
+{
+    unsigned solves;            // times the problem was solved
+    unsigned sweeps;            // passes over the worklist
+    unsigned long long visits;  // blocks whose sets were recomputed
+    unsigned long long swept;   // blocks a pass over all of dfo[] per sweep would have
+} flowstats[FLOWmax];
+
+/*************************************
+ * Start solving a dataflow problem by worklist.
+ * Returns:
+ *      worklist of blocks whose sets are to be recomputed, with
+ *      every block in dfo[] on it
+ */
+
+STATIC vec_t flowstart(int kind)
+{   vec_t pending = vec_calloc(dfotop);
+
+    vec_set(pending);
+    flowstats[kind].solves++;
+    return pending;
+}
+
+/*************************************
+ * Put the blocks in list bl on the worklist, because the sets they
+ * are computed from have changed.
+ * The worklist is indexed by DFO, or by reverse DFO for problems
+ * that are solved backwards, so a sweep from the lowest index up
+ * visits the blocks in the order the sets flow.
+ */
+
+STATIC void flowpending(vec_t pending,list_t bl,bool backward)
+{
+    for (; bl; bl = list_next(bl))
+    {   block *b = list_block(bl);
+        unsigned i = b->Bdfoidx;
+
+        if (i < dfotop && dfo[i] == b)  // ignore blocks not in dfo[]
+            vec_setbit(backward ? dfotop - 1 - i : i,pending);
+    }
+}
+
+/*************************************
+ * Finish a sweep over the worklist.
+ * Returns:
+ *      true if there are blocks left on it
+ */
+
+STATIC bool flowagain(int kind,vec_t pending)
+{
+    flowstats[kind].sweeps++;
+    flowstats[kind].swept += dfotop;
+    return vec_index(0,pending) < dfotop;
+}
+
+/*************************************
+ * Print the work done solving dataflow problems so far.
+ */
+
+void flowstats_print()
+{
+    for (int kind = 0; kind < FLOWmax; kind++)
+    {   FlowStats *fs = &flowstats[kind];
+
+        if (fs->solves)
+            printf("flow      %-3s %u solves in %u sweeps, %llu blocks visited of %llu swept\n",
+                flowname[kind],fs->solves,fs->sweeps,fs->visits,fs->swept);
+    }
+}
 
 /***************** REACHING DEFINITIONS *********************/
 
@@ -69,9 +147,8 @@ STATIC void flowaecp(void);
  */
 
 void flowrd()
-{       register vec_t tmp;
-        register unsigned i;
-        register bool anychng;
+{       register unsigned i;
+        vec_t pending;
 
         rdgenkill();            /* Compute Bgen and Bkill for RDs       */
         if (deftop == 0)        /* if no definition elems               */
@@ -80,19 +157,22 @@ void flowrd()
         /* The transfer equation is:                                    */
         /*      Bin = union of Bouts of all predecessors of B.          */
         /*      Bout = (Bin - Bkill) | Bgen                             */
-        /* Using Ullman's algorithm:                                    */
+        /* Using Ullman's algorithm, recomputing only the blocks with  */
+        /* a predecessor whose Bout changed:                           */
 
         for (i = 0; i < dfotop; i++)
                 vec_copy(dfo[i]->Boutrd,dfo[i]->Bgen);
 
-        tmp = vec_calloc(deftop);
+        pending = flowstart(FLOWrd);
         do
-        {       anychng = FALSE;
-                for (i = 0; i < dfotop; i++)    /* for each block       */
+        {       /* for each block on the worklist, in DFO              */
+                for (i = 0; (i = vec_index(i,pending)) < dfotop; i++)
                 {       register block *b;
                         register list_t bp;
 
                         b = dfo[i];
+                        vec_clearbit(i,pending);
+                        flowstats[FLOWrd].visits++;
 
                         /* Binrd = union of Boutrds of all predecessors of b */
                         vec_clear(b->Binrd);
@@ -106,14 +186,11 @@ void flowrd()
                                 vec_orass(b->Binrd,list_block(bp)->Boutrd);
                         }
                         /* Bout = (Bin - Bkill) | Bgen */
-                        vec_sub(tmp,b->Binrd,b->Bkill);
-                        vec_orass(tmp,b->Bgen);
-                        if (!anychng)
-                                anychng = !vec_equal(tmp,b->Boutrd);
-                        vec_copy(b->Boutrd,tmp);
+                        if (vec_subor(b->Boutrd,b->Binrd,b->Bkill,b->Bgen))
+                            flowpending(pending,b->Bsucc,false);
                 }
-        } while (anychng);              /* while any changes to Boutrd  */
-        vec_free(tmp);
+        } while (flowagain(FLOWrd,pending));    /* while any changes to Boutrd  */
+        vec_free(pending);
 
 #if 0
         dbg_printf("Reaching definitions\n");
@@ -348,9 +425,9 @@ void flowcp()
  */
 
 STATIC void flowaecp()
-{       vec_t tmp;
-        register unsigned i;
-        bool anychng;
+{       register unsigned i;
+        vec_t pending;
+        int kind = (flowxx == AE) ? FLOWae : FLOWcp;
 
         aecpgenkill();          /* Compute Bgen and Bkill for AEs or CPs */
         if (exptop <= 1)        /* if no expressions                    */
@@ -359,7 +436,9 @@ STATIC void flowaecp()
         /* The transfer equation is:                    */
         /*      Bin = & Bout(all predecessors P of B)   */
         /*      Bout = (Bin - Bkill) | Bgen             */
-        /* Using Ullman's algorithm:                    */
+        /* Using Ullman's algorithm, recomputing only   */
+        /* the blocks with a predecessor whose Bout or  */
+        /* Bout2 changed:                               */
 
         vec_clear(startblock->Bin);
         vec_copy(startblock->Bout,startblock->Bgen); /* these never change */
@@ -373,23 +452,24 @@ STATIC void flowaecp()
                 vec_set(b->Bin);        /* Bin = all expressions        */
 
                 /* Bout = (Bin - Bkill) | Bgen  */
-                vec_sub(b->Bout,b->Bin,b->Bkill);
-                vec_orass(b->Bout,b->Bgen);
+                vec_subor(b->Bout,b->Bin,b->Bkill,b->Bgen);
                 if (b->BC == BCiftrue)
-                {   vec_sub(b->Bout2,b->Bin,b->Bkill2);
-                    vec_orass(b->Bout2,b->Bgen2);
-                }
+                    vec_subor(b->Bout2,b->Bin,b->Bkill2,b->Bgen2);
         }
 
-        tmp = vec_calloc(exptop);
+        pending = flowstart(kind);
+        vec_clearbit(0,pending);        // startblock is never recomputed
         do
-        {   anychng = FALSE;
-
-            // For all blocks except startblock
-            for (i = 1; i < dfotop; i++)
+        {
+            // For all blocks on the worklist, in DFO
+            for (i = 1; (i = vec_index(i,pending)) < dfotop; i++)
             {   block *b = dfo[i];
                 list_t bl = b->Bpred;
                 block *bp;
+                bool changed = false;
+
+                vec_clearbit(i,pending);
+                flowstats[kind].visits++;
 
                 // Bin = & of Bout of all predecessors
                 // Bout = (Bin - Bkill) | Bgen
@@ -411,49 +491,21 @@ STATIC void flowaecp()
                         vec_andass(b->Bin,bp->Bout);
                 }
 
-                if (anychng)
-                {   vec_sub(b->Bout,b->Bin,b->Bkill);
-                    vec_orass(b->Bout,b->Bgen);
-                }
-                else
-                {   vec_sub(tmp,b->Bin,b->Bkill);
-                    vec_orass(tmp,b->Bgen);
-                    if (!vec_equal(tmp,b->Bout))
-                    {   // Swap Bout and tmp instead of
-                        // copying tmp over Bout
-                        vec_t v;
-
-                        v = tmp;
-                        tmp = b->Bout;
-                        b->Bout = v;
-                        anychng = TRUE;
-                    }
-                }
+                if (vec_subor(b->Bout,b->Bin,b->Bkill,b->Bgen))
+                    changed = true;
 
                 if (b->BC == BCiftrue)
                 {   // Bout2 = (Bin - Bkill2) | Bgen2
-                    if (anychng)
-                    {   vec_sub(b->Bout2,b->Bin,b->Bkill2);
-                        vec_orass(b->Bout2,b->Bgen2);
-                    }
-                    else
-                    {   vec_sub(tmp,b->Bin,b->Bkill2);
-                        vec_orass(tmp,b->Bgen2);
-                        if (!vec_equal(tmp,b->Bout2))
-                        {   // Swap Bout and tmp instead of
-                            // copying tmp over Bout2
-                            vec_t v;
-
-                            v = tmp;
-                            tmp = b->Bout2;
-                            b->Bout2 = v;
-                            anychng = TRUE;
-                        }
-                    }
+                    if (vec_subor(b->Bout2,b->Bin,b->Bkill2,b->Bgen2))
+                        changed = true;
                 }
+
+                if (changed)
+                    flowpending(pending,b->Bsucc,false);
             }
-        } while (anychng);
-        vec_free(tmp);
+            vec_clearbit(0,pending);    // even if it follows another block
+        } while (flowagain(kind,pending));
+        vec_free(pending);
 }
 
 /******************************
@@ -1136,9 +1188,9 @@ STATIC void accumaecpx(elem *n)
  */
 
 void flowlv()
-{       vec_t tmp,livexit;
+{       vec_t livexit;
         register unsigned i;
-        bool anychng;
+        vec_t pending;
         unsigned cnt;
 
         lvgenkill();            /* compute Bgen and Bkill for LVs.      */
@@ -1156,23 +1208,26 @@ void flowlv()
         /* The transfer equation is:                            */
         /*      Bin = (Bout - Bkill) | Bgen                     */
         /*      Bout = union of Bin of all successors to B.     */
-        /* Using Ullman's algorithm:                            */
+        /* Using Ullman's algorithm, recomputing only the       */
+        /* blocks with a successor whose Bin changed:           */
 
         for (i = 0; i < dfotop; i++)            /* for each block B     */
         {
                 vec_copy(dfo[i]->Binlv,dfo[i]->Bgen);   /* Binlv = Bgen */
         }
 
-        tmp = vec_calloc(globsym.top);
+        pending = flowstart(FLOWlv);
         cnt = 0;
         do
-        {       anychng = FALSE;
-
-                /* For each block B in reverse DFO order        */
-                for (i = dfotop; i--;)
-                {       register block *b = dfo[i];
+        {
+                /* For each block B on the worklist in reverse DFO order */
+                for (unsigned j = 0; (j = vec_index(j,pending)) < dfotop; j++)
+                {       register block *b = dfo[dfotop - 1 - j];
                         register list_t bl = b->Bsucc;
 
+                        vec_clearbit(j,pending);
+                        flowstats[FLOWlv].visits++;
+
                         /* Bout = union of Bins of all successors to B. */
                         if (bl)
                         {       vec_copy(b->Boutlv,list_block(bl)->Binlv);
@@ -1186,16 +1241,13 @@ void flowlv()
                         }
 
                         /* Bin = (Bout - Bkill) | Bgen                  */
-                        vec_sub(tmp,b->Boutlv,b->Bkill);
-                        vec_orass(tmp,b->Bgen);
-                        if (!anychng)
-                                anychng = !vec_equal(tmp,b->Binlv);
-                        vec_copy(b->Binlv,tmp);
+                        if (vec_subor(b->Binlv,b->Boutlv,b->Bkill,b->Bgen))
+                            flowpending(pending,b->Bpred,true);
                 }
                 cnt++;
                 assert(cnt < 50);
-        } while (anychng);
-        vec_free(tmp);
+        } while (flowagain(FLOWlv,pending));
+        vec_free(pending);
         vec_free(livexit);
 #if 0
         dbg_printf("Live variables\n");
@@ -1442,9 +1494,8 @@ STATIC void accumlv(vec_t GEN,vec_t KILL,elem *n)
  */
 
 void flowvbe()
-{       vec_t tmp;
-        unsigned i;
-        bool anychng;
+{       unsigned i;
+        vec_t pending;
 
         flowxx = VBE;
         aecpgenkill();          /* compute Bgen and Bkill for VBEs      */
@@ -1457,7 +1508,9 @@ void flowvbe()
         /* The transfer equation is:                    */
         /*      Bout = & Bin(all successors S of B)     */
         /*      Bin =(Bout - Bkill) | Bgen              */
-        /* Using Ullman's algorithm:                    */
+        /* Using Ullman's algorithm, recomputing only   */
+        /* the blocks with a successor whose Bin        */
+        /* changed:                                     */
 
         /*dbg_printf("defkill = "); vec_println(defkill);
         dbg_printf("starkill = "); vec_println(starkill);*/
@@ -1475,21 +1528,22 @@ void flowvbe()
                         vec_set(b->Bout);
 
                 /* Bin = (Bout - Bkill) | Bgen  */
-                vec_sub(b->Bin,b->Bout,b->Bkill);
-                vec_orass(b->Bin,b->Bgen);
+                vec_subor(b->Bin,b->Bout,b->Bkill,b->Bgen);
         }
 
-        tmp = vec_calloc(exptop);
+        pending = flowstart(FLOWvbe);
         do
-        {       anychng = FALSE;
-
-                /* for all blocks except return blocks in reverse dfo order */
-                for (i = dfotop; i--;)
-                {       block *b = dfo[i];
+        {
+                /* for all blocks on the worklist except return blocks */
+                /* in reverse dfo order                                 */
+                for (unsigned j = 0; (j = vec_index(j,pending)) < dfotop; j++)
+                {       block *b = dfo[dfotop - 1 - j];
                         list_t bl;
 
+                        vec_clearbit(j,pending);
                         if (b->BC == BCret || b->BC == BCretexp || b->BC == BCexit)
                                 continue;
+                        flowstats[FLOWvbe].visits++;
 
                         /* Bout = & of Bin of all successors */
                         bl = b->Bsucc;
@@ -1503,14 +1557,11 @@ void flowvbe()
                         }
 
                         /* Bin = (Bout - Bkill) | Bgen  */
-                        vec_sub(tmp,b->Bout,b->Bkill);
-                        vec_orass(tmp,b->Bgen);
-                        if (!anychng)
-                                anychng = !vec_equal(tmp,b->Bin);
-                        vec_copy(b->Bin,tmp);
+                        if (vec_subor(b->Bin,b->Bout,b->Bkill,b->Bgen))
+                            flowpending(pending,b->Bpred,true);
                 }
-        } while (anychng);      /* while any changes occurred to any Bin */
-        vec_free(tmp);
+        } while (flowagain(FLOWvbe,pending));   /* while any changes occurred to any Bin */
+        vec_free(pending);
 }
 
 /*************************************
@@ -26,6 +26,21 @@
 static char __file__[] = __FILE__;      /* for tassert.h                */
 #include        "tassert.h"
 
+#if MARS
+extern void warning(const char *filename, unsigned linnum, unsigned charnum, const char *format, ...);
+#endif
+
+/* The budget for optimizing a function. Past it, only the optimizations
+ * that work on an expression or block at a time are done.
+ * The dataflow vectors of the global optimizations grow with both the
+ * number of blocks and the number of elems, so the size of a function
+ * is measured as the two multiplied. Generated code like parser tables
+ * can have tens of thousands of elems in one function.
+ */
+#define OPTBUDGETsize   250000000               // blocks * elems
+#define OPTBUDGETtime   (30 * CLOCKS_PER_SEC)   // time spent in optfunc()
+#define MFcheap         (MFtree | MFdc | MFlocal | MFtime)
+
 /****************************
  * Terminate use of globals.
  */
@@ -188,6 +203,23 @@ void dbg_optprint(char *title)
 }
 #endif
 
+/****************************
+ * Drop the global optimizations of the function being optimized,
+ * and say so.
+ */
+
+STATIC void optbudget(const char *why)
+{
+    if (!(mfoptim & ~MFcheap))
+        return;                         // already dropped
+    mfoptim &= MFcheap;
+#if MARS
+    Srcpos *p = &funcsym_p->Sfunc->Fstartline;
+    const char *id = funcsym_p->prettyIdent ? funcsym_p->prettyIdent : funcsym_p->Sident;
+    warning(p->Sfilename, p->Slinnum, 0, "function %s %s, only optimizing it locally", id, why);
+#endif
+}
+
 /****************************
  * Optimize function.
  */
@@ -198,6 +230,7 @@ void optfunc()
     block *b;
     int iter;           // iteration count
     clock_t starttime;
+    mftype mfoptimsave = mfoptim;
 
     cmes ("optfunc()\n");
     dbg_optprint("optfunc\n");
@@ -223,18 +256,24 @@ void optfunc()
     // The infinite loop check needs to take this into account.
     // Add 100 just to give optimizer more rope to try to converge.
     int iterationLimit = 0;
+    unsigned long long nblocks = 0;
+    unsigned long long nelems = 0;
     for (b = startblock; b; b = b->Bnext)
     {
+        nblocks++;
         if (!b->Belem)
             continue;
         int d = el_countCommas(b->Belem) + 100;
         if (d > iterationLimit)
             iterationLimit = d;
+        nelems += el_countNodes(b->Belem);
     }
 
     // Some functions can take enormous amounts of time to optimize.
     // We try to put a lid on it.
     starttime = clock();
+    if (nblocks * nelems > OPTBUDGETsize)
+        optbudget("is too big to optimize");
     do
     {
         //printf("iter = %d\n", iter);
@@ -288,7 +327,9 @@ void optfunc()
 
         if (mfoptim & MFcnp)
             boolopt();                  // optimize boolean values
-        if (changes && mfoptim & MFloop && (clock() - starttime) < 30 * CLOCKS_PER_SEC)
+        if (clock() - starttime >= OPTBUDGETtime)
+            optbudget("takes too long to optimize");
+        if (changes && mfoptim & MFloop)
             continue;
 
         if (mfoptim & MFcnp)
@@ -330,7 +371,9 @@ void optfunc()
             rmdeadass();                /* remove dead assignments       */
 
         cmes2 ("changes = %d\n", changes);
-        if (!(changes && mfoptim & MFloop && (clock() - starttime) < 30 * CLOCKS_PER_SEC))
+        if (clock() - starttime >= OPTBUDGETtime)
+            optbudget("takes too long to optimize");
+        if (!(changes && mfoptim & MFloop))
             break;
     } while (1);
     cmes2("%d iterations\n",iter);
@@ -344,10 +387,13 @@ void optfunc()
     }
     if (mfoptim & MFvbe)
         verybusyexp();              /* very busy expressions         */
+    if (clock() - starttime >= OPTBUDGETtime)
+        optbudget("takes too long to optimize");
     if (mfoptim & MFcse)
         builddags();                /* common subexpressions         */
     if (mfoptim & MFdv)
         deadvar();                  /* eliminate dead variables      */
+    mfoptim = mfoptimsave;
 
 #ifdef DEBUG
     if (debugb)
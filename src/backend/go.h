@@ -72,6 +72,7 @@ void opt_arraybounds();
 /* gflow.c */
 void flowrd(),flowlv(),flowae(),flowvbe(),
      flowcp(),flowae(),genkillae(),flowarraybounds();
+void flowstats_print();
 int ae_field_affect(elem *lvalue,elem *e);
 
 /* glocal.c */
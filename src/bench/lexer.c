@@ -0,0 +1,143 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/bench/lexer.c
+ */
+
+/* Lexer micro-benchmark.
+ *
+ *      lexbench [-n passes] [files...]
+ *
+ * Lexes the given D source files, or a generated mix of the kinds of
+ * text the lexer skips over in bulk (indentation, comments, identifiers,
+ * long string literals), and prints the best throughput of the passes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rmem.h"
+#include "root.h"
+#include "port.h"
+
+#include "mars.h"
+#include "lexer.h"
+
+/**************************************
+ * Generate about size bytes of D source.
+ */
+
+static void generate(OutBuffer *buf, size_t size)
+{
+    unsigned seed = 1;
+    for (unsigned n = 0; buf->offset < size; n++)
+    {
+        seed = seed * 1103515245 + 12345;
+        switch (n % 6)
+        {
+            case 0:
+                buf->writestring("/** Documentation comment for the declaration that follows,\n"
+                                 " * long enough to span a couple of lines of ordinary prose.\n"
+                                 " */\n");
+                break;
+
+            case 1:
+                buf->printf("        int someLongerIdentifierName%u = anotherIdentifier_%u + %u; // trailing comment\n",
+                    n, seed % 1000, seed % 97);
+                break;
+
+            case 2:
+                buf->printf("    immutable string tableEntry%u = \"Lorem ipsum dolor sit amet, consectetur "
+                            "adipiscing elit, sed do eiusmod tempor incididunt %u\\n\";\n", n, seed);
+                break;
+
+            case 3:
+                buf->writestring("    /+ nested /+ comment +/ with some text inside of it +/\n");
+                break;
+
+            case 4:
+                buf->printf("            if (condition%u && !otherCondition) callFunction(argument, %u);\n",
+                    n, seed % 10);
+                break;
+
+            case 5:
+                buf->printf("    enum wysiwyg%u = `C:\\path\\to\\some\\file\\in\\a\\raw\\string.txt`;\n", n);
+                break;
+        }
+    }
+    buf->writeByte(0);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned passes = 10;
+    Strings files;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            passes = atoi(argv[++i]);
+        else
+            files.push(argv[i]);
+    }
+
+    global.init();
+    global.gag = 1;                     // count the errors, but don't print them
+    Lexer::initLexer();
+
+    /* Each file is lexed on its own, as __EOF__ or a stray 0x1A
+     * would end the lexing of everything after it.
+     */
+    Array<OutBuffer *> sources;
+    for (size_t i = 0; i < files.dim; i++)
+    {
+        File f(files[i]);
+        if (f.read())
+        {
+            fprintf(stderr, "lexbench: cannot read %s\n", files[i]);
+            return EXIT_FAILURE;
+        }
+        OutBuffer *buf = new OutBuffer();
+        buf->write(f.buffer, f.len);
+        buf->writeByte(0);
+        sources.push(buf);
+    }
+    if (!files.dim)
+    {
+        OutBuffer *buf = new OutBuffer();
+        generate(buf, 16 * 1024 * 1024);
+        sources.push(buf);
+    }
+
+    size_t len = 0;
+    for (size_t i = 0; i < sources.dim; i++)
+        len += sources[i]->offset - 1;
+
+    unsigned long long best = 0;
+    size_t ntokens = 0;
+    for (unsigned pass = 0; pass < passes; pass++)
+    {
+        unsigned long long start = Port::nanoseconds();
+        ntokens = 0;
+        for (size_t i = 0; i < sources.dim; i++)
+        {
+            Lexer lex("lexbench", (utf8_t *)sources[i]->data, 0, sources[i]->offset - 1, 1, 0);
+            while (lex.nextToken() != TOKeof)
+                ntokens++;
+        }
+        unsigned long long t = Port::nanoseconds() - start;
+        if (!best || t < best)
+            best = t;
+    }
+
+    printf("lexer: %llu bytes, %llu tokens, best of %u: %.2f ms, %.1f MB/s\n",
+        (ulonglong)len, (ulonglong)ntokens, passes,
+        best / 1e6, len * 1e3 / (best ? best : 1));
+    if (global.errors)
+        printf("lexer: %u errors\n", global.errors / passes);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/bench/regalloc.c
+ */
+
+/* Register allocator benchmark.
+ *
+ *      regbench [-n repeats]
+ *
+ * Times the numeric kernels of kernels.d as compiled by dmd -O with
+ * -regalloc=weight and with -regalloc=color, and checks they get the
+ * same answers. The two take turns, each run calling the kernel for
+ * at least 20 ms, and the best of repeats runs is kept.
+ *
+ * Where code sits in memory can make more difference than what it is,
+ * so the makefile starts each kernel on a page of its own, and passes
+ * in SAME_CODE the kernels the two allocators compile to the same code.
+ * Those are marked: what they show is the noise in the measurement.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "port.h"
+
+typedef unsigned char ubyte;
+
+#define KERNELS(alloc) \
+extern "C" double alloc##_dot(const double *a, const double *b, size_t n); \
+extern "C" double alloc##_matmul(const double *a, const double *b, double *c, size_t n); \
+extern "C" size_t alloc##_sieve(ubyte *flags, size_t n); \
+extern "C" unsigned alloc##_crc32(const ubyte *p, size_t n, unsigned *table); \
+extern "C" unsigned alloc##_mandel(int w, int h, int maxiter); \
+extern "C" float alloc##_stencil(float *a, float *b, size_t n, int steps); \
+extern "C" unsigned long long alloc##_collatz(unsigned long long n);
+
+KERNELS(weight)
+KERNELS(color)
+
+/* The kernels are called without the D runtime; this is the only part
+ * of it the objects refer to.
+ */
+extern "C" void _d_dso_registry(void *data) { }
+
+#ifndef SAME_CODE
+#define SAME_CODE ""           // " name name ... "
+#endif
+
+static int nrepeats = 5;
+
+enum { N = 1 << 20, M = 160 };
+
+static double *da, *db, *dc;
+static float *fa, *fb;
+static ubyte *bytes;
+static unsigned table[256];
+
+/**************************************
+ * Run kernel k once, compiled with the color allocator if color is set,
+ * else the weight one.
+ * Returns:
+ *      nanoseconds taken, and the checksum in *sum
+ */
+
+static unsigned long long once(int k, bool color, double *sum)
+{
+    for (size_t i = 0; i < N; i++)
+        fa[i] = (float)(i % 1000);
+    unsigned long long start = Port::nanoseconds();
+    switch (k)
+    {
+        case 0: *sum = (color ? color_dot : weight_dot)(da, db, N); break;
+        case 1: *sum = (color ? color_matmul : weight_matmul)(da, db, dc, M); break;
+        case 2: *sum = (color ? color_sieve : weight_sieve)(bytes, N * 8); break;
+        case 3: *sum = (color ? color_crc32 : weight_crc32)(bytes, N * 8, table); break;
+        case 4: *sum = (color ? color_mandel : weight_mandel)(400, 300, 200); break;
+        case 5: *sum = (color ? color_stencil : weight_stencil)(fa, fb, N, 10); break;
+        case 6: *sum = (double)(color ? color_collatz : weight_collatz)(300000); break;
+    }
+    return Port::nanoseconds() - start;
+}
+
+/**************************************
+ * Time kernel k with both allocators, taking turns at going first.
+ * Returns:
+ *      best milliseconds per call in t[color], and the checksums in sum[color]
+ */
+
+static void run(int k, double t[2], double sum[2])
+{
+    t[0] = t[1] = 1e300;
+    for (int r = 0; r < nrepeats; r++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            int color = (r + i) & 1;
+            unsigned long long total = 0;
+            size_t calls = 0;
+            do
+            {
+                total += once(k, color != 0, &sum[color]);
+                calls++;
+            } while (total < 20000000);
+            double ms = total / 1e6 / calls;
+            if (ms < t[color])
+                t[color] = ms;
+        }
+    }
+}
+
+static const char *kernelName[] = { "dot", "matmul", "sieve", "crc32", "mandel", "stencil", "collatz" };
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            nrepeats = atoi(argv[++i]);
+    }
+    if (nrepeats < 1)
+        nrepeats = 1;
+
+    da = (double *)malloc(N * sizeof(double));
+    db = (double *)malloc(N * sizeof(double));
+    dc = (double *)malloc(M * M * sizeof(double));
+    fa = (float *)malloc(N * sizeof(float));
+    fb = (float *)malloc(N * sizeof(float));
+    bytes = (ubyte *)malloc(N * 8);
+    for (size_t i = 0; i < N; i++)
+    {
+        da[i] = (double)(i % 17) / 16;
+        db[i] = (double)(i % 13) / 12;
+    }
+
+    bool failed = false;
+    for (int k = 0; k < 7; k++)
+    {
+        double t[2], sum[2];
+        run(k, t, sum);
+        char name[16];
+        sprintf(name, " %s ", kernelName[k]);
+        printf("regalloc: %-8s: weight %8.2f ms, color %8.2f ms, %5.2fx%s\n",
+            kernelName[k], t[0], t[1], t[0] / t[1],
+            strstr(SAME_CODE, name) ? ", same code" : "");
+        if (sum[0] != sum[1])
+        {
+            printf("regalloc: %s gets %g with weight, %g with color\n", kernelName[k], sum[0], sum[1]);
+            failed = true;
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/bench/sched.c
+ */
+
+/* Instruction scheduler benchmark.
+ *
+ *      schedbench [-n repeats]
+ *
+ * Times the numeric kernels of kernels.d as compiled by dmd -O -m64 with
+ * -mcpu=baseline, -mcpu=skylake and -mcpu=zen, and checks they get the
+ * same answers. The three take turns, each run calling the kernel for
+ * at least 20 ms, and the best of repeats runs is kept.
+ * Run it on the processor being scheduled for; on others the numbers
+ * say little.
+ *
+ * As for regbench, the makefile starts each kernel on a page of its own,
+ * and passes in SAME_SKYLAKE and SAME_ZEN the kernels that are scheduled
+ * no differently from -mcpu=baseline. Those are marked: what they show
+ * is the noise in the measurement.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "port.h"
+
+typedef unsigned char ubyte;
+
+#define KERNELS(cpu) \
+extern "C" double cpu##_dot(const double *a, const double *b, size_t n); \
+extern "C" double cpu##_matmul(const double *a, const double *b, double *c, size_t n); \
+extern "C" size_t cpu##_sieve(ubyte *flags, size_t n); \
+extern "C" unsigned cpu##_crc32(const ubyte *p, size_t n, unsigned *table); \
+extern "C" unsigned cpu##_mandel(int w, int h, int maxiter); \
+extern "C" float cpu##_stencil(float *a, float *b, size_t n, int steps); \
+extern "C" unsigned long long cpu##_collatz(unsigned long long n);
+
+KERNELS(base)
+KERNELS(skylake)
+KERNELS(zen)
+
+/* The kernels are called without the D runtime; this is the only part
+ * of it the objects refer to.
+ */
+extern "C" void _d_dso_registry(void *data) { }
+
+#ifndef SAME_SKYLAKE
+#define SAME_SKYLAKE ""        // " name name ... "
+#endif
+#ifndef SAME_ZEN
+#define SAME_ZEN ""
+#endif
+
+static int nrepeats = 5;
+
+enum { N = 1 << 20, M = 160 };
+
+static double *da, *db, *dc;
+static float *fa, *fb;
+static ubyte *bytes;
+static unsigned table[256];
+
+enum Cpu { BASELINE, SKYLAKE, ZEN };
+
+static const char *cpuName[] = { "baseline", "skylake", "zen" };
+
+#define PICK(cpu, k) (cpu == SKYLAKE ? skylake_##k : cpu == ZEN ? zen_##k : base_##k)
+
+/**************************************
+ * Run kernel k once, as scheduled for cpu.
+ * Returns:
+ *      nanoseconds taken, and the checksum in *sum
+ */
+
+static unsigned long long once(int k, Cpu cpu, double *sum)
+{
+    for (size_t i = 0; i < N; i++)
+        fa[i] = (float)(i % 1000);
+    unsigned long long start = Port::nanoseconds();
+    switch (k)
+    {
+        case 0: *sum = PICK(cpu, dot)(da, db, N); break;
+        case 1: *sum = PICK(cpu, matmul)(da, db, dc, M); break;
+        case 2: *sum = PICK(cpu, sieve)(bytes, N * 8); break;
+        case 3: *sum = PICK(cpu, crc32)(bytes, N * 8, table); break;
+        case 4: *sum = PICK(cpu, mandel)(400, 300, 200); break;
+        case 5: *sum = PICK(cpu, stencil)(fa, fb, N, 10); break;
+        case 6: *sum = (double)PICK(cpu, collatz)(300000); break;
+    }
+    return Port::nanoseconds() - start;
+}
+
+/**************************************
+ * Time kernel k as scheduled for each cpu, taking turns at going first.
+ * Returns:
+ *      best milliseconds per call in t[cpu], and the checksums in sum[cpu]
+ */
+
+static void run(int k, double t[3], double sum[3])
+{
+    t[BASELINE] = t[SKYLAKE] = t[ZEN] = 1e300;
+    for (int r = 0; r < nrepeats; r++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            int c = (r + i) % 3;
+            unsigned long long total = 0;
+            size_t calls = 0;
+            do
+            {
+                total += once(k, (Cpu)c, &sum[c]);
+                calls++;
+            } while (total < 20000000);
+            double ms = total / 1e6 / calls;
+            if (ms < t[c])
+                t[c] = ms;
+        }
+    }
+}
+
+static const char *kernelName[] = { "dot", "matmul", "sieve", "crc32", "mandel", "stencil", "collatz" };
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            nrepeats = atoi(argv[++i]);
+    }
+    if (nrepeats < 1)
+        nrepeats = 1;
+
+    da = (double *)malloc(N * sizeof(double));
+    db = (double *)malloc(N * sizeof(double));
+    dc = (double *)malloc(M * M * sizeof(double));
+    fa = (float *)malloc(N * sizeof(float));
+    fb = (float *)malloc(N * sizeof(float));
+    bytes = (ubyte *)malloc(N * 8);
+    for (size_t i = 0; i < N; i++)
+    {
+        da[i] = (double)(i % 17) / 16;
+        db[i] = (double)(i % 13) / 12;
+    }
+
+    bool failed = false;
+    for (int k = 0; k < 7; k++)
+    {
+        double t[3], sum[3];
+        run(k, t, sum);
+        char name[16];
+        sprintf(name, " %s ", kernelName[k]);
+        printf("sched: %-8s: baseline %8.2f ms, skylake %8.2f ms %5.2fx%s, zen %8.2f ms %5.2fx%s\n",
+            kernelName[k], t[BASELINE],
+            t[SKYLAKE], t[BASELINE] / t[SKYLAKE], strstr(SAME_SKYLAKE, name) ? " (same)" : "",
+            t[ZEN], t[BASELINE] / t[ZEN], strstr(SAME_ZEN, name) ? " (same)" : "");
+        for (int c = SKYLAKE; c <= ZEN; c++)
+        {
+            if (sum[c] != sum[BASELINE])
+            {
+                printf("sched: %s gets %g with baseline, %g with %s\n",
+                    kernelName[k], sum[BASELINE], sum[c], cpuName[c]);
+                failed = true;
+            }
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/bench/stringtable.c
+ */
+
+/* String table contention benchmark.
+ *
+ *      stringtablebench [-n operations] [-s strings] [threads...]
+ *
+ * Each thread looks up or adds strings picked at random from a common
+ * set, as threads lexing different modules would with identifiers, first
+ * in a StringTable behind one mutex and then in a SharedStringTable.
+ * Every thread must get the same StringValue for the same string.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "rmem.h"
+#include "root.h"
+#include "port.h"
+#include "stringtable.h"
+
+static size_t nstrings = 100000;
+static size_t noperations = 2000000;    // per thread
+static char **strings;
+static size_t *lengths;
+static StringValue **first;             // [nstrings] value the first thread to get there got
+
+static StringTable lockedTable;
+static pthread_mutex_t lockedMutex = PTHREAD_MUTEX_INITIALIZER;
+static SharedStringTable sharedTable;
+
+static bool failed;
+
+static void check(size_t k, StringValue *sv)
+{
+    // Only write to first[] once, so checking doesn't add contention of its own
+    StringValue *prev = __atomic_load_n(&first[k], __ATOMIC_RELAXED);
+    if (!prev)
+        prev = __sync_val_compare_and_swap(&first[k], (StringValue *)NULL, sv);
+    if (prev && prev != sv || sv->length != lengths[k] || memcmp(sv->toDchars(), strings[k], lengths[k]) != 0)
+        failed = true;
+}
+
+static void *lockedThread(void *arg)
+{
+    unsigned seed = (unsigned)(size_t)arg;
+    for (size_t i = 0; i < noperations; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t k = (seed >> 8) % nstrings;
+        pthread_mutex_lock(&lockedMutex);
+        StringValue *sv = lockedTable.update(strings[k], lengths[k]);
+        pthread_mutex_unlock(&lockedMutex);
+        check(k, sv);
+    }
+    return NULL;
+}
+
+static void *sharedThread(void *arg)
+{
+    unsigned seed = (unsigned)(size_t)arg;
+    for (size_t i = 0; i < noperations; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t k = (seed >> 8) % nstrings;
+        check(k, sharedTable.update(strings[k], lengths[k]));
+    }
+    return NULL;
+}
+
+/**************************************
+ * Run fp on nthreads threads on a fresh table.
+ * Returns:
+ *      millions of operations per second
+ */
+
+static double run(void *(*fp)(void *), size_t nthreads)
+{
+    lockedTable.reset();
+    sharedTable.reset();
+    memset(first, 0, nstrings * sizeof(first[0]));
+
+    pthread_t *threads = (pthread_t *)mem.malloc(nthreads * sizeof(pthread_t));
+    unsigned long long start = Port::nanoseconds();
+    for (size_t i = 0; i < nthreads; i++)
+        pthread_create(&threads[i], NULL, fp, (void *)(i + 1));
+    for (size_t i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    unsigned long long t = Port::nanoseconds() - start;
+    mem.free(threads);
+
+    return nthreads * noperations * 1e3 / (t ? t : 1);
+}
+
+int main(int argc, char *argv[])
+{
+    Array<size_t> nthreads;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            noperations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            nstrings = atoi(argv[++i]);
+        else
+            nthreads.push(atoi(argv[i]));
+    }
+    if (!nthreads.dim)
+    {
+        nthreads.push(1);
+        nthreads.push(2);
+        nthreads.push(4);
+        nthreads.push(8);
+    }
+
+    strings = (char **)mem.malloc(nstrings * sizeof(strings[0]));
+    lengths = (size_t *)mem.malloc(nstrings * sizeof(lengths[0]));
+    first = (StringValue **)mem.malloc(nstrings * sizeof(first[0]));
+    for (size_t k = 0; k < nstrings; k++)
+    {
+        char buf[32];
+        lengths[k] = sprintf(buf, "identifier%llu", (ulonglong)k);
+        strings[k] = mem.strdup(buf);
+    }
+
+    lockedTable._init();
+    sharedTable._init();
+    for (size_t i = 0; i < nthreads.dim; i++)
+    {
+        double locked = run(&lockedThread, nthreads[i]);
+        double shared = run(&sharedThread, nthreads[i]);
+        printf("stringtable: %2llu threads: locked %7.2f, shared %7.2f Mops/s\n",
+            (ulonglong)nthreads[i], locked, shared);
+    }
+    if (failed)
+    {
+        printf("stringtable: threads got different values for the same string\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
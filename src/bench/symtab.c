@@ -0,0 +1,145 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/bench/symtab.c
+ */
+
+/* Symbol table micro-benchmark.
+ *
+ *      symtabbench [-n lookups] [sizes...]
+ *
+ * Fills symbol tables of each size, from a scope of a few locals to a
+ * generated module or enum of tens of thousands of members, and looks up
+ * names that are there and names that aren't, as a search through the
+ * scopes does. Each is timed with the FlatAA of a DsymbolTable, with and
+ * without being told its size up front, and with the chained AA that
+ * DsymbolTable used before.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rmem.h"
+#include "root.h"
+#include "port.h"
+#include "stringtable.h"
+#include "aav.h"
+
+static size_t nlookups = 10000000;
+
+static StringValue **names;     // names[0 .. size] are in the table, the rest not
+static void **symbols;
+static size_t sum;              // so the lookups aren't optimized away
+
+enum Kind { FLAT, HINTED, CHAINED };
+
+static const char *kindName[] = { "flat", "hinted", "chained" };
+
+/**************************************
+ * Fill tables with size symbols, enough of them to add 100000 symbols
+ * in all, then do nlookups lookups in the last one, 1 in 4 of which miss.
+ * Returns:
+ *      nanoseconds per symbol added in *insert, and per lookup
+ */
+
+static double run(Kind kind, size_t size, double *insert)
+{
+    size_t ntables = size < 100000 ? 100000 / size : 1;
+    FlatAA *tab = NULL;
+    AA *aa = NULL;
+    unsigned long long start = Port::nanoseconds();
+    for (size_t n = 0; n < ntables; n++)
+    {
+        if (kind == CHAINED)
+        {
+            aa = NULL;
+            for (size_t i = 0; i < size; i++)
+                *dmd_aaGet(&aa, names[i]) = symbols[i];
+        }
+        else
+        {
+            tab = new FlatAA(kind == HINTED ? size : 0);
+            for (size_t i = 0; i < size; i++)
+                *tab->get(names[i]) = symbols[i];
+        }
+    }
+    *insert = (double)(Port::nanoseconds() - start) / (ntables * size);
+
+    unsigned seed = 1;
+    start = Port::nanoseconds();
+    for (size_t n = 0; n < nlookups; n++)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t i = (seed >> 8) % size;
+        if ((seed & 3) == 0)
+            i += size;          // not in the table
+        void *s = kind == CHAINED ? dmd_aaGetRvalue(aa, names[i]) : tab->getRvalue(names[i]);
+        if (s != (i < size ? symbols[i] : NULL))
+        {
+            fprintf(stderr, "symtabbench: %s table lost %s\n", kindName[kind], names[i]->toDchars());
+            exit(EXIT_FAILURE);
+        }
+        sum += (size_t)s;
+    }
+    return (double)(Port::nanoseconds() - start) / nlookups;
+}
+
+int main(int argc, char *argv[])
+{
+    Array<size_t> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            nlookups = atoi(argv[++i]);
+        else
+            sizes.push(atoi(argv[i]));
+    }
+    if (!sizes.dim)
+    {
+        sizes.push(8);
+        sizes.push(64);
+        sizes.push(1000);
+        sizes.push(50000);
+    }
+
+    size_t maxsize = 1;
+    for (size_t i = 0; i < sizes.dim; i++)
+    {
+        if (sizes[i] > maxsize)
+            maxsize = sizes[i];
+    }
+
+    /* The keys are interned names and the values symbols, all allocated
+     * in the order the parser would, as Identifiers and Dsymbols are.
+     */
+    StringTable idtable;
+    idtable._init();
+    names = (StringValue **)mem.malloc(2 * maxsize * sizeof(names[0]));
+    symbols = (void **)mem.malloc(maxsize * sizeof(symbols[0]));
+    for (size_t i = 0; i < 2 * maxsize; i++)
+    {
+        char buf[32];
+        size_t len = sprintf(buf, "member%llu", (ulonglong)i);
+        names[i] = idtable.insert(buf, len);
+        if (i < maxsize)
+            symbols[i] = mem.malloc(64);
+    }
+
+    for (size_t i = 0; i < sizes.dim; i++)
+    {
+        size_t size = sizes[i] ? sizes[i] : 1;
+        for (int k = FLAT; k <= CHAINED; k++)
+        {
+            double insert;
+            double lookup = run((Kind)k, size, &insert);
+            printf("symtab: %6llu symbols, %-7s: add %6.1f ns, lookup %6.1f ns\n",
+                (ulonglong)size, kindName[k], insert, lookup);
+        }
+    }
+    return sum ? EXIT_SUCCESS : EXIT_FAILURE;
+}
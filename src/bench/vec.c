@@ -0,0 +1,200 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/bench/vec.c
+ */
+
+/* Bit vector micro-benchmark.
+ *
+ *      vecbench [-n words] [bits...]
+ *
+ * Runs the step the optimizer's dataflow problems take for a block,
+ * Bout = (Bin - Bkill) | Bgen and a check for whether Bout changed, over
+ * vectors of each number of bits, as flowrd() sees them for functions
+ * with that many definitions. Each is timed with the word at a time
+ * loops vec_sub(), vec_orass() and vec_equal(), and with vec_subor().
+ * A pass of vec_index() over sparse vectors is timed alongside.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "port.h"
+#include "vec.h"
+
+static size_t nwords = 200000000;       // words of vector to go through per kernel
+static size_t sum;                      // so the work isn't optimized away
+
+/**************************************
+ * The loops of vec.c before vec_subor() and the bit scan in vec_index(),
+ * kept out of line as the library functions are.
+ */
+
+__attribute__((noinline)) static void word_sub(vec_t v1, vec_t v2, vec_t v3)
+{
+    for (vec_t vtop = &v1[vec_dim(v1)]; v1 < vtop; v1++, v2++, v3++)
+        *v1 = *v2 & ~*v3;
+}
+
+__attribute__((noinline)) static void word_orass(vec_t v1, vec_t v2)
+{
+    for (vec_t vtop = &v1[vec_dim(v1)]; v1 < vtop; v1++, v2++)
+        *v1 |= *v2;
+}
+
+__attribute__((noinline)) static size_t word_index(size_t b, vec_t vec)
+{
+    vec_t v = vec;
+    if (b < vec_numbits(v))
+    {
+        vec_t vtop = &vec[vec_dim(v)];
+        size_t bit = b & VECMASK;
+        if (bit != b)
+            v += b >> VECSHIFT;
+        size_t starv = *v >> bit;
+        while (1)
+        {
+            while (starv)
+            {
+                if (starv & 1)
+                    return b;
+                b++;
+                starv >>= 1;
+            }
+            b = (b + VECBITS) & ~VECMASK;
+            if (++v >= vtop)
+                break;
+            starv = *v;
+        }
+    }
+    return vec_numbits(vec);
+}
+
+enum Kernel { TRANSFER, INDEX };
+
+static const char *kernelName[] = { "transfer", "index" };
+
+/**************************************
+ * Run kernel k over vectors of nbits bits until nwords words have been
+ * gone through, the old way if word is set.
+ * Returns:
+ *      nanoseconds per pass over a vector
+ */
+
+static double run(Kernel k, bool word, size_t nbits)
+{
+    vec_t in = vec_calloc(nbits);
+    vec_t kill = vec_calloc(nbits);
+    vec_t gen = vec_calloc(nbits);
+    vec_t out = vec_calloc(nbits);
+    vec_t tmp = vec_calloc(nbits);
+
+    /* Definitions reach, are killed and generated sparsely, a few
+     * to a word.
+     */
+    unsigned seed = 1;
+    for (size_t i = 0; i < nbits; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = seed >> 8;
+        if (r % 4 == 0)
+            vec_setbit(i, in);
+        if (r % 7 == 0)
+            vec_setbit(i, kill);
+        if (r % 13 == 0)
+            vec_setbit(i, gen);
+    }
+
+    size_t npasses = nwords / vec_dim(in);
+    if (!npasses)
+        npasses = 1;
+    unsigned long long start = Port::nanoseconds();
+    for (size_t n = 0; n < npasses; n++)
+    {
+        switch (k)
+        {
+            case TRANSFER:
+                // flip a bit of Bin, so Bout changes every other pass
+                in[n % vec_dim(in)] ^= 2;
+                if (word)
+                {
+                    word_sub(tmp, in, kill);
+                    word_orass(tmp, gen);
+                    if (!vec_equal(tmp, out))
+                    {
+                        vec_t v = tmp;
+                        tmp = out;
+                        out = v;
+                        sum++;
+                    }
+                }
+                else if (vec_subor(out, in, kill, gen))
+                    sum++;
+                break;
+
+            case INDEX:
+                if (word)
+                {
+                    for (size_t i = 0; (i = word_index(i, gen)) < nbits; i++)
+                        sum += i;
+                }
+                else
+                {
+                    for (size_t i = 0; (i = vec_index(i, gen)) < nbits; i++)
+                        sum += i;
+                }
+                break;
+        }
+    }
+    double t = (double)(Port::nanoseconds() - start) / npasses;
+
+    vec_free(in);
+    vec_free(kill);
+    vec_free(gen);
+    vec_free(out);
+    vec_free(tmp);
+    return t;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t nsizes = 0;
+    size_t *sizes = (size_t *)malloc(argc * sizeof(sizes[0]) + 6 * sizeof(sizes[0]));
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            nwords = atoi(argv[++i]);
+        else
+            sizes[nsizes++] = atoi(argv[i]);
+    }
+    if (!nsizes)
+    {
+        sizes[nsizes++] = 64;
+        sizes[nsizes++] = 256;
+        sizes[nsizes++] = 1024;
+        sizes[nsizes++] = 4096;
+        sizes[nsizes++] = 16384;
+        sizes[nsizes++] = 65536;
+    }
+
+    vec_init();
+    for (size_t i = 0; i < nsizes; i++)
+    {
+        size_t nbits = sizes[i] ? sizes[i] : 1;
+        for (int k = TRANSFER; k <= INDEX; k++)
+        {
+            double word = run((Kernel)k, true, nbits);
+            double now = run((Kernel)k, false, nbits);
+            printf("vec: %6llu bits, %-8s: word %9.1f ns, now %9.1f ns, %5.2fx\n",
+                (unsigned long long)nbits, kernelName[k], word, now, word / now);
+        }
+    }
+    vec_term();
+    free(sizes);
+    return sum ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1244 @@
+
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/bytecode.c
+ */
+
+/* A bytecode compiler and register based virtual machine for the part
+ * of CTFE that only deals in integers: functions whose parameters, locals
+ * and return value all have integral types, and which use nothing but
+ * loops, if, switch, integer arithmetic and calls to other such functions.
+ *
+ * Anything else makes the compiler give up on the function, and anything
+ * the interpreter would have to diagnose (a failed assert, division by
+ * zero, running too deep, ...) makes the VM give up on the call. Either
+ * way bcInterpret() returns NULL and the caller evaluates the call with
+ * the AST interpreter in interpret.c, which then produces exactly the
+ * diagnostics it always did. As the functions have no side effects beyond
+ * their own locals, starting over is always safe.
+ *
+ * Values are held in 64 bits, normalized for their type the way
+ * IntegerExp::normalize() does it: sign extended for signed types, zero
+ * extended for unsigned ones, and 0 or 1 for bool.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "rmem.h"
+#include "aav.h"
+
+#include "mars.h"
+#include "mtype.h"
+#include "statement.h"
+#include "expression.h"
+#include "declaration.h"
+#include "init.h"
+#include "visitor.h"
+#include "ctfe.h"
+
+enum BCKind
+{
+    BKbool,
+    BKi8, BKu8,
+    BKi16, BKu16,
+    BKi32, BKu32,
+    BKi64, BKu64,
+};
+
+enum BCOp
+{
+    BCconst,                    // r[a] = consts[b]
+    BCmov,                      // r[a] = r[b]
+    BCadd, BCsub, BCmul,        // r[a] = r[b] op r[c]
+    BCdiv, BCmod,
+    BCand, BCor, BCxor,
+    BCshl, BCshr, BCushr,
+    BCeq, BCne, BClt, BCle,     // r[a] = r[b] op r[c], signedness by kind
+    BCneg, BCcom, BCnot,        // r[a] = op r[b]
+    BCconv,                     // r[a] = r[b] converted to kind
+    BCjmp,                      // goto a
+    BCjz,                       // if (!r[b]) goto a
+    BCjnz,                      // if (r[b]) goto a
+    BCcall,                     // r[a] = callees[b](r[c], r[c + 1], ...)
+    BCret,                      // return r[a]
+    BCfail,                     // give up, let the interpreter do it
+};
+
+struct BCInstr
+{
+    unsigned char op;           // BCOp
+    unsigned char kind;         // BCKind of the operation
+    int a, b, c;
+};
+
+struct BCFunction
+{
+    FuncDeclaration *fd;
+    bool ok;                    // false if fd cannot be compiled to bytecode
+    unsigned nparams;           // arguments are passed in r[0 .. nparams]
+    unsigned nregs;             // registers needed for a call
+    int kind;                   // BCKind of return value
+    Array<BCInstr> code;
+    Array<dinteger_t> consts;
+    FuncDeclarations callees;
+};
+
+static int kindOf(Type *t)
+{
+    if (!t)
+        return -1;
+    switch (t->toBasetype()->ty)
+    {
+        case Tbool:     return BKbool;
+        case Tint8:     return BKi8;
+        case Tuns8:     return BKu8;
+        case Tchar:     return BKu8;
+        case Tint16:    return BKi16;
+        case Tuns16:    return BKu16;
+        case Twchar:    return BKu16;
+        case Tint32:    return BKi32;
+        case Tuns32:    return BKu32;
+        case Tdchar:    return BKu32;
+        case Tint64:    return BKi64;
+        case Tuns64:    return BKu64;
+        default:        return -1;
+    }
+}
+
+static inline bool isSigned(int kind)
+{
+    return kind == BKi8 || kind == BKi16 || kind == BKi32 || kind == BKi64;
+}
+
+static inline unsigned bitsOf(int kind)
+{
+    switch (kind)
+    {
+        case BKbool:    return 1;
+        case BKi8:
+        case BKu8:      return 8;
+        case BKi16:
+        case BKu16:     return 16;
+        case BKi32:
+        case BKu32:     return 32;
+        default:        return 64;
+    }
+}
+
+static inline dinteger_t normalize(int kind, dinteger_t v)
+{
+    switch (kind)
+    {
+        case BKbool:    return v != 0;
+        case BKi8:      return (sinteger_t)(d_int8)v;
+        case BKu8:      return (d_uns8)v;
+        case BKi16:     return (sinteger_t)(d_int16)v;
+        case BKu16:     return (d_uns16)v;
+        case BKi32:     return (sinteger_t)(d_int32)v;
+        case BKu32:     return (d_uns32)v;
+        default:        return v;
+    }
+}
+
+/************************************************
+ * Compiler.
+ *
+ * Variables are numbered as they are declared, temporaries are reused
+ * once the statement using them is done. As the number of variables is
+ * only known at the end, registers are encoded as -1 - index for
+ * variables and index for temporaries while compiling, and are mapped
+ * to variables first, temporaries after, by finish().
+ */
+
+struct BCTarget
+{
+    BCTarget *prev;
+    SwitchStatement *sw;        // NULL for loops
+    Array<size_t> breaks;       // jumps to patch with the break address
+    Array<size_t> continues;    // jumps to patch with the continue address
+
+    // For switches
+    Array<size_t> caseaddr;     // address of each case, indexed like sw->cases
+    size_t defaultaddr;
+    Array<size_t> gotos;        // jumps to patch with a case address
+    Array<size_t> gotocases;    // and the index of that case, or ~0 for default
+
+    BCTarget(BCTarget *prev, SwitchStatement *sw)
+    {
+        this->prev = prev;
+        this->sw = sw;
+        defaultaddr = ~(size_t)0;
+    }
+};
+
+class BCCompiler : public Visitor
+{
+public:
+    BCFunction *bf;
+    bool failed;
+    int result;                 // register holding the value of the last expression
+
+    AA *vars;                   // VarDeclaration* => 1 + variable index
+    int nvars;
+    int ntemps;                 // temporaries in use
+    int maxtemps;
+
+    BCTarget *targets;          // innermost enclosing loop or switch
+
+    BCCompiler(BCFunction *bf)
+    {
+        this->bf = bf;
+        failed = false;
+        result = 0;
+        vars = NULL;
+        nvars = 0;
+        ntemps = 0;
+        maxtemps = 0;
+        targets = NULL;
+    }
+
+    size_t emit(int op, int kind, int a, int b = 0, int c = 0)
+    {
+        BCInstr i;
+        i.op = (unsigned char)op;
+        i.kind = (unsigned char)kind;
+        i.a = a;
+        i.b = b;
+        i.c = c;
+        bf->code.push(i);
+        return bf->code.dim - 1;
+    }
+
+    size_t here()
+    {
+        return bf->code.dim;
+    }
+
+    void patch(Array<size_t> *jumps, size_t addr)
+    {
+        for (size_t i = 0; i < jumps->dim; i++)
+            bf->code[(*jumps)[i]].a = (int)addr;
+    }
+
+    int newTemp()
+    {
+        int t = ntemps++;
+        if (ntemps > maxtemps)
+            maxtemps = ntemps;
+        return t;
+    }
+
+    int declare(VarDeclaration *v)
+    {
+        int r = -1 - nvars++;
+        *(size_t *)dmd_aaGet(&vars, v) = (size_t)nvars;
+        return r;
+    }
+
+    int lookup(VarDeclaration *v)
+    {
+        size_t i = (size_t)dmd_aaGetRvalue(vars, v);
+        return i ? -(int)i : 0;
+    }
+
+    /* Return the register of variable e refers to, 0 if none
+     */
+    int lvalue(Expression *e)
+    {
+        if (e->op != TOKvar)
+            return 0;
+        VarDeclaration *v = ((VarExp *)e)->var->isVarDeclaration();
+        return v ? lookup(v) : 0;
+    }
+
+    int constant(dinteger_t value, int kind)
+    {
+        bf->consts.push(value);
+        int t = newTemp();
+        emit(BCconst, kind, t, (int)bf->consts.dim - 1);
+        return t;
+    }
+
+    /* Compile e, return the register holding its value
+     */
+    int expression(Expression *e)
+    {
+        if (failed)
+            return 0;
+        result = 0;
+        e->accept(this);
+        return result;
+    }
+
+    /* Like expression(), but e must have an integral type
+     */
+    int value(Expression *e)
+    {
+        if (kindOf(e->type) < 0)
+            failed = true;
+        return expression(e);
+    }
+
+    void statement(Statement *s)
+    {
+        if (s && !failed)
+        {
+            ntemps = 0;
+            s->accept(this);
+        }
+    }
+
+    bool compile(FuncDeclaration *fd)
+    {
+        TypeFunction *tf = (TypeFunction *)fd->type->toBasetype();
+        if (!fd->fbody || fd->vthis || fd->isNested() || fd->vresult ||
+            fd->frequire || fd->fensure || fd->semantic3Errors ||
+            tf->varargs || tf->isref || (bf->kind = kindOf(tf->next)) < 0)
+            return false;
+        size_t dim = fd->parameters ? fd->parameters->dim : 0;
+        for (size_t i = 0; i < dim; i++)
+        {
+            VarDeclaration *v = (*fd->parameters)[i];
+            if (v->storage_class & (STCref | STCout | STClazy) || kindOf(v->type) < 0)
+                return false;
+            declare(v);
+        }
+        bf->nparams = (unsigned)dim;
+
+        statement(fd->fbody);
+        emit(BCfail, 0, 0);         // fell off the end
+        if (failed)
+            return false;
+        finish();
+        return true;
+    }
+
+    void finish()
+    {
+        for (size_t i = 0; i < bf->code.dim; i++)
+        {
+            BCInstr *in = &bf->code[i];
+            switch (in->op)
+            {
+                case BCconst:
+                case BCret:
+                    in->a = reg(in->a);
+                    break;
+
+                case BCmov: case BCneg: case BCcom: case BCnot: case BCconv:
+                    in->a = reg(in->a);
+                    in->b = reg(in->b);
+                    break;
+
+                case BCjz: case BCjnz:
+                    in->b = reg(in->b);
+                    break;
+
+                case BCcall:
+                    in->a = reg(in->a);
+                    in->c = reg(in->c);
+                    break;
+
+                case BCjmp: case BCfail:
+                    break;
+
+                default:
+                    in->a = reg(in->a);
+                    in->b = reg(in->b);
+                    in->c = reg(in->c);
+                    break;
+            }
+        }
+        bf->nregs = nvars + maxtemps;
+    }
+
+    int reg(int r)
+    {
+        return r < 0 ? -1 - r : nvars + r;
+    }
+
+    /******************************* Statements ***************************/
+
+    void visit(Statement *s)
+    {
+        failed = true;
+    }
+
+    void visit(ExpStatement *s)
+    {
+        if (s->exp)
+            expression(s->exp);
+    }
+
+    void visit(DtorExpStatement *s)
+    {
+        failed = true;
+    }
+
+    void visit(CompoundStatement *s)
+    {
+        for (size_t i = 0; i < s->statements->dim; i++)
+            statement((*s->statements)[i]);
+    }
+
+    void visit(CompoundAsmStatement *s)
+    {
+        failed = true;
+    }
+
+    void visit(ScopeStatement *s)
+    {
+        statement(s->statement);
+    }
+
+    void visit(ImportStatement *s)
+    {
+    }
+
+    void visit(IfStatement *s)
+    {
+        if (s->match)
+        {
+            failed = true;
+            return;
+        }
+        int c = expression(s->condition);
+        size_t jelse = emit(BCjz, 0, 0, c);
+        statement(s->ifbody);
+        if (s->elsebody)
+        {
+            size_t jend = emit(BCjmp, 0, 0);
+            bf->code[jelse].a = (int)here();
+            statement(s->elsebody);
+            bf->code[jend].a = (int)here();
+        }
+        else
+            bf->code[jelse].a = (int)here();
+    }
+
+    void loop(Statement *init, Expression *condition, Expression *increment,
+        Statement *body, bool testfirst)
+    {
+        BCTarget t(targets, NULL);
+        statement(init);
+        size_t top = here();
+        if (testfirst && condition)
+        {
+            ntemps = 0;
+            int c = expression(condition);
+            t.breaks.push(emit(BCjz, 0, 0, c));
+        }
+        targets = &t;
+        statement(body);
+        targets = t.prev;
+        patch(&t.continues, here());
+        ntemps = 0;
+        if (increment)
+            expression(increment);
+        if (!testfirst)
+        {
+            int c = expression(condition);
+            emit(BCjnz, 0, (int)top, c);
+        }
+        else
+            emit(BCjmp, 0, (int)top);
+        patch(&t.breaks, here());
+    }
+
+    void visit(ForStatement *s)
+    {
+        loop(s->init, s->condition, s->increment, s->body, true);
+    }
+
+    void visit(WhileStatement *s)
+    {
+        loop(NULL, s->condition, NULL, s->body, true);
+    }
+
+    void visit(DoStatement *s)
+    {
+        loop(NULL, s->condition, NULL, s->body, false);
+    }
+
+    void visit(BreakStatement *s)
+    {
+        if (s->ident || !targets)
+        {
+            failed = true;
+            return;
+        }
+        targets->breaks.push(emit(BCjmp, 0, 0));
+    }
+
+    void visit(ContinueStatement *s)
+    {
+        BCTarget *t = targets;
+        while (t && t->sw)
+            t = t->prev;
+        if (s->ident || !t)
+        {
+            failed = true;
+            return;
+        }
+        t->continues.push(emit(BCjmp, 0, 0));
+    }
+
+    void visit(ReturnStatement *s)
+    {
+        if (!s->exp || s->caseDim || kindOf(s->exp->type) != bf->kind)
+        {
+            failed = true;
+            return;
+        }
+        emit(BCret, 0, value(s->exp));
+    }
+
+    void visit(SwitchStatement *s)
+    {
+        if (s->hasVars || !s->cases)
+        {
+            failed = true;
+            return;
+        }
+        int kind = kindOf(s->condition->type);
+        int c = value(s->condition);
+        if (failed)
+            return;
+
+        BCTarget t(targets, s);
+        t.caseaddr.setDim(s->cases->dim);
+        for (size_t i = 0; i < s->cases->dim; i++)
+        {
+            Expression *ec = (*s->cases)[i]->exp;
+            if (ec->op != TOKint64)
+            {
+                failed = true;
+                return;
+            }
+            t.caseaddr[i] = ~(size_t)0;
+            int k = constant(ec->toInteger(), kind);
+            int r = newTemp();
+            emit(BCeq, kind, r, c, k);
+            t.gotos.push(emit(BCjnz, 0, 0, r));
+            t.gotocases.push(i);
+        }
+        t.gotos.push(emit(BCjmp, 0, 0));
+        t.gotocases.push(s->sdefault ? ~(size_t)0 : ~(size_t)1);
+
+        targets = &t;
+        statement(s->body);
+        targets = t.prev;
+        if (failed)
+            return;
+
+        size_t end = here();
+        for (size_t i = 0; i < t.gotos.dim; i++)
+        {
+            size_t n = t.gotocases[i];
+            size_t addr = n == ~(size_t)0 ? t.defaultaddr
+                        : n == ~(size_t)1 ? end
+                        : t.caseaddr[n];
+            if (addr == ~(size_t)0)
+            {
+                failed = true;
+                return;
+            }
+            bf->code[t.gotos[i]].a = (int)addr;
+        }
+        patch(&t.breaks, end);
+    }
+
+    BCTarget *innerSwitch()
+    {
+        BCTarget *t = targets;
+        while (t && !t->sw)
+            t = t->prev;
+        if (!t)
+            failed = true;
+        return t;
+    }
+
+    void visit(CaseStatement *s)
+    {
+        BCTarget *t = innerSwitch();
+        if (!t)
+            return;
+        for (size_t i = 0; i < t->sw->cases->dim; i++)
+        {
+            if ((*t->sw->cases)[i] == s)
+            {
+                t->caseaddr[i] = here();
+                statement(s->statement);
+                return;
+            }
+        }
+        failed = true;
+    }
+
+    void visit(DefaultStatement *s)
+    {
+        BCTarget *t = innerSwitch();
+        if (!t)
+            return;
+        t->defaultaddr = here();
+        statement(s->statement);
+    }
+
+    void visit(GotoCaseStatement *s)
+    {
+        BCTarget *t = innerSwitch();
+        if (!t)
+            return;
+        for (size_t i = 0; i < t->sw->cases->dim; i++)
+        {
+            if ((*t->sw->cases)[i] == s->cs)
+            {
+                t->gotos.push(emit(BCjmp, 0, 0));
+                t->gotocases.push(i);
+                return;
+            }
+        }
+        failed = true;
+    }
+
+    void visit(GotoDefaultStatement *s)
+    {
+        BCTarget *t = innerSwitch();
+        if (!t)
+            return;
+        t->gotos.push(emit(BCjmp, 0, 0));
+        t->gotocases.push(~(size_t)0);
+    }
+
+    void visit(SwitchErrorStatement *s)
+    {
+        emit(BCfail, 0, 0);
+    }
+
+    /******************************* Expressions ***************************/
+
+    void visit(Expression *e)
+    {
+        failed = true;
+    }
+
+    void visit(IntegerExp *e)
+    {
+        int kind = kindOf(e->type);
+        if (kind < 0)
+        {
+            failed = true;
+            return;
+        }
+        result = constant(normalize(kind, e->getInteger()), kind);
+    }
+
+    void visit(VarExp *e)
+    {
+        result = lvalue(e);
+        if (!result)
+            failed = true;
+    }
+
+    void visit(DeclarationExp *e)
+    {
+        VarDeclaration *v = e->declaration->isVarDeclaration();
+        if (!v)
+            return;             // the interpreter ignores these too
+        if (v->isStatic())
+            return;
+        if (v->toAlias()->isTupleDeclaration() || v->isDataseg() ||
+            v->storage_class & (STCmanifest | STCref | STCout | STClazy) ||
+            kindOf(v->type) < 0 || !v->init)
+        {
+            failed = true;
+            return;
+        }
+        ExpInitializer *ie = v->init->isExpInitializer();
+        if (!ie)
+        {
+            failed = true;
+            return;
+        }
+        result = declare(v);
+        expression(ie->exp);
+    }
+
+    void visit(AssignExp *e)
+    {
+        int v = lvalue(e->e1);
+        if (!v || kindOf(e->e1->type) != kindOf(e->e2->type))
+        {
+            failed = true;
+            return;
+        }
+        int r = value(e->e2);
+        emit(BCmov, 0, v, r);
+        result = v;
+    }
+
+    void visit(BinAssignExp *e)
+    {
+        int op;
+        switch (e->op)
+        {
+            case TOKaddass:     op = BCadd;     break;
+            case TOKminass:     op = BCsub;     break;
+            case TOKmulass:     op = BCmul;     break;
+            case TOKdivass:     op = BCdiv;     break;
+            case TOKmodass:     op = BCmod;     break;
+            case TOKandass:     op = BCand;     break;
+            case TOKorass:      op = BCor;      break;
+            case TOKxorass:     op = BCxor;     break;
+            case TOKshlass:     op = BCshl;     break;
+            case TOKshrass:     op = BCshr;     break;
+            case TOKushrass:    op = BCushr;    break;
+            default:
+                failed = true;
+                return;
+        }
+        int v = lvalue(e->e1);
+        int kind = kindOf(e->e1->type);
+        int kind2 = kindOf(e->e2->type);
+        if (!v || kind2 < 0 || hasSideEffect(e->e2) ||
+            (kind != kind2 && op != BCshl && op != BCshr && op != BCushr &&
+             kind2 != BKi32 && kind2 != BKu32))
+        {
+            failed = true;
+            return;
+        }
+        /* Small types are promoted to int for the operation, as in
+         * 'b += 300' with 'byte b'. Doing the operation in int and then
+         * truncating gives the same result for everything but division
+         * and shifts to the right.
+         */
+        if (kind != kind2 && (op == BCdiv || op == BCmod))
+        {
+            failed = true;
+            return;
+        }
+        if (kind != kind2 && (op == BCshr || op == BCushr) && bitsOf(kind) < 32)
+        {
+            failed = true;
+            return;
+        }
+        int r = expression(e->e2);
+        emit(op, kind, v, v, r);
+        result = v;
+    }
+
+    void visit(PostExp *e)
+    {
+        int v = lvalue(e->e1);
+        int kind = kindOf(e->e1->type);
+        if (!v || kind < 0)
+        {
+            failed = true;
+            return;
+        }
+        int t = newTemp();
+        emit(BCmov, 0, t, v);
+        int one = constant(1, kind);
+        emit(e->op == TOKplusplus ? BCadd : BCsub, kind, v, v, one);
+        result = t;
+    }
+
+    /* Evaluate e1 and e2 in that order, making sure the value of e1
+     * is not changed by e2
+     */
+    void operands(BinExp *e, int *r1, int *r2)
+    {
+        *r1 = value(e->e1);
+        if (*r1 < 0 && hasSideEffect(e->e2))
+        {
+            int t = newTemp();
+            emit(BCmov, 0, t, *r1);
+            *r1 = t;
+        }
+        *r2 = value(e->e2);
+    }
+
+    void visit(BinExp *e)
+    {
+        int op;
+        bool swap = false;
+        switch (e->op)
+        {
+            case TOKadd:        op = BCadd;     break;
+            case TOKmin:        op = BCsub;     break;
+            case TOKmul:        op = BCmul;     break;
+            case TOKdiv:        op = BCdiv;     break;
+            case TOKmod:        op = BCmod;     break;
+            case TOKand:        op = BCand;     break;
+            case TOKor:         op = BCor;      break;
+            case TOKxor:        op = BCxor;     break;
+            case TOKshl:        op = BCshl;     break;
+            case TOKshr:        op = BCshr;     break;
+            case TOKushr:       op = BCushr;    break;
+            case TOKequal:
+            case TOKidentity:   op = BCeq;      break;
+            case TOKnotequal:
+            case TOKnotidentity: op = BCne;     break;
+            case TOKlt:         op = BClt;      break;
+            case TOKle:         op = BCle;      break;
+            case TOKgt:         op = BClt; swap = true; break;
+            case TOKge:         op = BCle; swap = true; break;
+            default:
+                failed = true;
+                return;
+        }
+        int kind = kindOf(e->type);
+        int kind1 = kindOf(e->e1->type);
+        int kind2 = kindOf(e->e2->type);
+        if (kind < 0 || kind1 < 0 || kind2 < 0)
+        {
+            failed = true;
+            return;
+        }
+        if (op >= BCeq)
+        {
+            // Comparisons are done in the type of the operands
+            if (kind1 != kind2)
+            {
+                failed = true;
+                return;
+            }
+            kind = kind1;
+        }
+        else if (kind != kind1 || (kind != kind2 && op != BCshl && op != BCshr && op != BCushr))
+        {
+            failed = true;
+            return;
+        }
+
+        int r1, r2;
+        operands(e, &r1, &r2);
+        int t = newTemp();
+        if (swap)
+            emit(op, kind, t, r2, r1);
+        else
+            emit(op, kind, t, r1, r2);
+        result = t;
+    }
+
+    void visit(AndAndExp *e)
+    {
+        logical(e, BCjz);
+    }
+
+    void visit(OrOrExp *e)
+    {
+        logical(e, BCjnz);
+    }
+
+    void logical(BinExp *e, int jop)
+    {
+        if (kindOf(e->type) != BKbool)
+        {
+            failed = true;
+            return;
+        }
+        int t = newTemp();
+        int r1 = value(e->e1);
+        emit(BCconv, BKbool, t, r1);
+        size_t j = emit(jop, 0, 0, t);
+        int r2 = value(e->e2);
+        emit(BCconv, BKbool, t, r2);
+        bf->code[j].a = (int)here();
+        result = t;
+    }
+
+    void unary(UnaExp *e, int op, int kind)
+    {
+        if (kind < 0 || kindOf(e->e1->type) < 0)
+        {
+            failed = true;
+            return;
+        }
+        int r = expression(e->e1);
+        int t = newTemp();
+        emit(op, kind, t, r);
+        result = t;
+    }
+
+    void visit(NegExp *e)
+    {
+        int kind = kindOf(e->type);
+        unary(e, BCneg, kind == kindOf(e->e1->type) ? kind : -1);
+    }
+
+    void visit(ComExp *e)
+    {
+        int kind = kindOf(e->type);
+        unary(e, BCcom, kind == kindOf(e->e1->type) ? kind : -1);
+    }
+
+    void visit(NotExp *e)
+    {
+        unary(e, BCnot, kindOf(e->type) == BKbool ? BKbool : -1);
+    }
+
+    void visit(CastExp *e)
+    {
+        unary(e, BCconv, kindOf(e->type));
+    }
+
+    void visit(CondExp *e)
+    {
+        int kind = kindOf(e->type);
+        if (kind < 0)
+        {
+            failed = true;
+            return;
+        }
+        int t = newTemp();
+        int c = expression(e->econd);
+        size_t jelse = emit(BCjz, 0, 0, c);
+        emit(BCmov, 0, t, value(e->e1));
+        size_t jend = emit(BCjmp, 0, 0);
+        bf->code[jelse].a = (int)here();
+        emit(BCmov, 0, t, value(e->e2));
+        bf->code[jend].a = (int)here();
+        result = t;
+    }
+
+    void visit(CommaExp *e)
+    {
+        expression(e->e1);
+        result = expression(e->e2);
+    }
+
+    void visit(AssertExp *e)
+    {
+        int c = expression(e->e1);
+        size_t j = emit(BCjnz, 0, 0, c);
+        emit(BCfail, 0, 0);
+        bf->code[j].a = (int)here();
+        result = c;
+    }
+
+    void visit(HaltExp *e)
+    {
+        emit(BCfail, 0, 0);
+    }
+
+    void visit(CallExp *e)
+    {
+        FuncDeclaration *f = NULL;
+        if (e->e1->op == TOKvar)
+            f = ((VarExp *)e->e1)->var->isFuncDeclaration();
+        if (!f || f->isNested() || f->needThis() || kindOf(e->type) < 0)
+        {
+            failed = true;
+            return;
+        }
+        TypeFunction *tf = (TypeFunction *)f->type->toBasetype();
+        size_t dim = e->arguments ? e->arguments->dim : 0;
+        if (tf->varargs || tf->isref || Parameter::dim(tf->parameters) != dim)
+        {
+            failed = true;
+            return;
+        }
+        for (size_t i = 0; i < dim; i++)
+        {
+            Parameter *p = Parameter::getNth(tf->parameters, i);
+            if (p->storageClass & (STCref | STCout | STClazy) ||
+                kindOf(p->type) < 0 || kindOf(p->type) != kindOf((*e->arguments)[i]->type))
+            {
+                failed = true;
+                return;
+            }
+        }
+
+        // Arguments go into consecutive temporaries
+        int args = ntemps;
+        ntemps += (int)dim;
+        if (ntemps > maxtemps)
+            maxtemps = ntemps;
+        for (size_t i = 0; i < dim; i++)
+            emit(BCmov, 0, args + (int)i, expression((*e->arguments)[i]));
+
+        bf->callees.push(f);
+        int t = newTemp();
+        emit(BCcall, 0, t, (int)bf->callees.dim - 1, args);
+        result = t;
+    }
+};
+
+/* Return the bytecode for fd, compiling it if necessary.
+ * Return NULL if fd cannot be called at compile time right now;
+ * the interpreter will say why.
+ */
+static BCFunction *bcFunction(FuncDeclaration *fd)
+{
+    if (!fd->ctfeBytecode)
+    {
+        if (fd->semanticRun == PASSsemantic3)
+            return NULL;
+        if (!fd->functionSemantic3())
+            return NULL;
+        if (fd->semanticRun < PASSsemantic3done)
+            return NULL;
+
+        BCFunction *bf = new BCFunction();
+        bf->fd = fd;
+        bf->nparams = 0;
+        bf->nregs = 0;
+        bf->kind = -1;
+        BCCompiler bcc(bf);
+        bf->ok = bcc.compile(fd);
+        if (!bf->ok)
+        {
+            bf->code.setDim(0);
+            bf->consts.setDim(0);
+            bf->callees.setDim(0);
+        }
+        fd->ctfeBytecode = bf;
+    }
+    return fd->ctfeBytecode;
+}
+
+/************************************************
+ * Virtual machine.
+ */
+
+static dinteger_t *bcstack;     // registers of all active calls
+static size_t bcstackdim;       // allocated size of bcstack[]
+static size_t bcstacktop;       // registers in use
+
+static void bcReserve(size_t dim)
+{
+    if (dim > bcstackdim)
+    {
+        bcstackdim = dim * 2 + 256;
+        bcstack = (dinteger_t *)mem.realloc(bcstack, bcstackdim * sizeof(dinteger_t));
+    }
+}
+
+/* Run f with its registers at bcstack[base], which must be reserved
+ * and counted in bcstacktop.
+ * Return false if it has to be left to the interpreter.
+ */
+static bool bcRun(BCFunction *f, size_t base, int depth, dinteger_t *presult)
+{
+    BCInstr *code = f->code.tdata();
+    dinteger_t *consts = f->consts.tdata();
+    dinteger_t *r = bcstack + base;
+    size_t pc = 0;
+
+    while (1)
+    {
+        BCInstr *i = &code[pc++];
+        int kind = i->kind;
+        switch (i->op)
+        {
+            case BCconst:
+                r[i->a] = consts[i->b];
+                break;
+
+            case BCmov:
+                r[i->a] = r[i->b];
+                break;
+
+            case BCadd:
+                r[i->a] = normalize(kind, r[i->b] + r[i->c]);
+                break;
+
+            case BCsub:
+                r[i->a] = normalize(kind, r[i->b] - r[i->c]);
+                break;
+
+            case BCmul:
+                r[i->a] = normalize(kind, r[i->b] * r[i->c]);
+                break;
+
+            case BCdiv:
+            case BCmod:
+            {
+                dinteger_t n = r[i->b];
+                dinteger_t d = r[i->c];
+                dinteger_t v;
+                if (d == 0)
+                    return false;
+                if (isSigned(kind))
+                {
+                    if ((sinteger_t)d == -1 && n == (dinteger_t)1 << 63)
+                        return false;   // overflow trap
+                    v = i->op == BCdiv ? (sinteger_t)n / (sinteger_t)d
+                                       : (sinteger_t)n % (sinteger_t)d;
+                }
+                else
+                    v = i->op == BCdiv ? n / d : n % d;
+                r[i->a] = normalize(kind, v);
+                break;
+            }
+
+            case BCand:
+                r[i->a] = normalize(kind, r[i->b] & r[i->c]);
+                break;
+
+            case BCor:
+                r[i->a] = normalize(kind, r[i->b] | r[i->c]);
+                break;
+
+            case BCxor:
+                r[i->a] = normalize(kind, r[i->b] ^ r[i->c]);
+                break;
+
+            case BCshl:
+            case BCshr:
+            case BCushr:
+            {
+                dinteger_t v = r[i->b];
+                dinteger_t n = r[i->c];
+                unsigned bits = bitsOf(kind);
+                if (n >= bits)
+                    return false;       // the interpreter errors on these
+                if (i->op == BCshl)
+                    v <<= n;
+                else if (i->op == BCshr && isSigned(kind))
+                    v = (sinteger_t)v >> n;
+                else
+                {
+                    if (bits < 64)
+                        v &= ((dinteger_t)1 << bits) - 1;
+                    v >>= n;
+                }
+                r[i->a] = normalize(kind, v);
+                break;
+            }
+
+            case BCeq:
+                r[i->a] = r[i->b] == r[i->c];
+                break;
+
+            case BCne:
+                r[i->a] = r[i->b] != r[i->c];
+                break;
+
+            case BClt:
+                r[i->a] = isSigned(kind) ? (sinteger_t)r[i->b] < (sinteger_t)r[i->c]
+                                         : r[i->b] < r[i->c];
+                break;
+
+            case BCle:
+                r[i->a] = isSigned(kind) ? (sinteger_t)r[i->b] <= (sinteger_t)r[i->c]
+                                         : r[i->b] <= r[i->c];
+                break;
+
+            case BCneg:
+                r[i->a] = normalize(kind, 0 - r[i->b]);
+                break;
+
+            case BCcom:
+                r[i->a] = normalize(kind, ~r[i->b]);
+                break;
+
+            case BCnot:
+                r[i->a] = r[i->b] == 0;
+                break;
+
+            case BCconv:
+                r[i->a] = normalize(kind, r[i->b]);
+                break;
+
+            case BCjmp:
+                pc = i->a;
+                break;
+
+            case BCjz:
+                if (!r[i->b])
+                    pc = i->a;
+                break;
+
+            case BCjnz:
+                if (r[i->b])
+                    pc = i->a;
+                break;
+
+            case BCcall:
+            {
+                if (depth <= 0)
+                    return false;
+                BCFunction *g = bcFunction(f->callees[i->b]);
+                if (!g || !g->ok)
+                {
+                    /* Don't let the interpreter retry f in bytecode for each
+                     * level of a recursion that ends up here.
+                     */
+                    f->ok = false;
+                    return false;
+                }
+                // Compiling g may have run CTFE, which left bcstacktop as it was
+                size_t gbase = base + f->nregs;
+                assert(bcstacktop == gbase);
+                bcReserve(gbase + g->nregs);
+                r = bcstack + base;
+                memcpy(r + f->nregs, r + i->c, g->nparams * sizeof(dinteger_t));
+                bcstacktop = gbase + g->nregs;
+                dinteger_t v;
+                bool ok = bcRun(g, gbase, depth - 1, &v);
+                bcstacktop = gbase;
+                if (!ok)
+                    return false;
+                r = bcstack + base;
+                r[i->a] = v;
+                break;
+            }
+
+            case BCret:
+                *presult = r[i->a];
+                return true;
+
+            case BCfail:
+                return false;
+
+            default:
+                assert(0);
+        }
+    }
+}
+
+/*************************************
+ * Call fd with the already interpreted arguments in bytecode,
+ * allowing for at most maxdepth nested calls.
+ * Returns:
+ *      the result, or NULL if the call has to be interpreted
+ */
+Expression *bcInterpret(FuncDeclaration *fd, Expressions *arguments, int maxdepth)
+{
+    BCFunction *f = bcFunction(fd);
+    if (!f || !f->ok || maxdepth <= 0)
+        return NULL;
+    size_t dim = arguments ? arguments->dim : 0;
+    if (dim != f->nparams)
+        return NULL;
+
+    size_t base = bcstacktop;
+    bcReserve(base + f->nregs);
+    for (size_t i = 0; i < dim; i++)
+    {
+        Expression *earg = (*arguments)[i];
+        if (earg->op != TOKint64)
+            return NULL;
+        VarDeclaration *v = (*fd->parameters)[i];
+        bcstack[base + i] = normalize(kindOf(v->type), earg->toInteger());
+    }
+
+    bcstacktop = base + f->nregs;
+    dinteger_t v;
+    bool ok = bcRun(f, base, maxdepth - 1, &v);
+    bcstacktop = base;
+    if (!ok)
+        return NULL;
+
+    TypeFunction *tf = (TypeFunction *)fd->type->toBasetype();
+    return new IntegerExp(fd->loc, v, tf->next);
+}
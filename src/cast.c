@@ -80,7 +80,7 @@ Expression *implicitCastTo(Expression *e, Scope *sc, Type *t)
                 return;
             }
 
-            if (t->ty != Terror && e->type->ty != Terror)
+            if (t->ty != Terror && e->type->ty != Terror && !global.gagError())
             {
                 if (!t->deco)
                 {
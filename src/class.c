@@ -326,6 +326,7 @@ void ClassDeclaration::semantic(Scope *sc)
         if (sizeok == SIZEOKdone || !scx)
         {
             semanticRun = PASSsemanticdone;
+            Module::wakeDeferredSemantic(this);
             return;
         }
     }
@@ -374,6 +375,8 @@ void ClassDeclaration::semantic(Scope *sc)
             goto Lancestorsdone;
         }
 
+        ClassDeclaration *waitingOn = NULL;   // first base not done yet
+
         // See if there's a base class as first in baseclasses[]
         if (baseclasses->dim)
         {
@@ -427,6 +430,8 @@ void ClassDeclaration::semantic(Scope *sc)
                 //printf("\ttry later, forward reference of base class %s\n", tc->sym->toChars());
                 if (tc->sym->scope)
                     tc->sym->scope->module->addDeferredSemantic(tc->sym);
+                if (!waitingOn)
+                    waitingOn = tc->sym;
                 doAncestorsSemantic = SemanticStart;
             }
          L7: ;
@@ -479,6 +484,8 @@ void ClassDeclaration::semantic(Scope *sc)
                 //printf("\ttry later, forward reference of base %s\n", tc->sym->toChars());
                 if (tc->sym->scope)
                     tc->sym->scope->module->addDeferredSemantic(tc->sym);
+                if (!waitingOn)
+                    waitingOn = tc->sym;
                 doAncestorsSemantic = SemanticStart;
             }
             i++;
@@ -488,11 +495,12 @@ void ClassDeclaration::semantic(Scope *sc)
             // Forward referencee of one or more bases, try again later
             scope = scx ? scx : sc->copy();
             scope->setNoFree();
-            scope->module->addDeferredSemantic(this);
+            scope->module->addDeferredSemantic(this, waitingOn);
             //printf("\tL%d semantic('%s') failed due to forward references\n", __LINE__, toChars());
             return;
         }
         doAncestorsSemantic = SemanticDone;
+        Module::wakeDeferredSemantic(this);
 
         // If no base class, and this is not an Object, use Object as base class
         if (!baseClass && ident != Id::Object && !cpp)
@@ -552,10 +560,11 @@ Lancestorsdone:
     if (!members)               // if opaque declaration
     {
         semanticRun = PASSsemanticdone;
+        Module::wakeDeferredSemantic(this);
         return;
     }
     if (!symtab)
-        symtab = new DsymbolTable();
+        symtab = new DsymbolTable(members->dim);
 
     for (size_t i = 0; i < baseclasses->dim; i++)
     {
@@ -571,7 +580,7 @@ Lancestorsdone:
             scope->setNoFree();
             if (tc->sym->scope)
                 tc->sym->scope->module->addDeferredSemantic(tc->sym);
-            scope->module->addDeferredSemantic(this);
+            scope->module->addDeferredSemantic(this, tc->sym);
             //printf("\tL%d semantic('%s') failed due to forward references\n", __LINE__, toChars());
             return;
         }
@@ -825,6 +834,7 @@ Lancestorsdone:
 
     Module::dprogress++;
     semanticRun = PASSsemanticdone;
+    Module::wakeDeferredSemantic(this);
 
     dtor = buildDtor(this, sc2);
     if (FuncDeclaration *f = hasIdentityOpAssign(this, sc2))
@@ -888,6 +898,7 @@ bool ClassDeclaration::isBaseOf(ClassDeclaration *cd, int *poffset)
          */
         if (!cd->baseClass && cd->scope && !cd->isInterfaceDeclaration())
         {
+            CtfeRegionSuspend suspend;
             cd->semantic(NULL);
             if (!cd->baseClass && cd->scope)
                 cd->error("base class is forward referenced by %s", toChars());
@@ -961,6 +972,17 @@ Dsymbol *ClassDeclaration::search(Loc loc, Identifier *ident, int flags)
     return s;
 }
 
+void ClassDeclaration::addSpellings(Speller *sp)
+{
+    ScopeDsymbol::addSpellings(sp);
+    for (size_t i = 0; i < baseclasses->dim; i++)
+    {
+        BaseClass *b = (*baseclasses)[i];
+        if (b->base)
+            b->base->showSpellings(sp);
+    }
+}
+
 ClassDeclaration *ClassDeclaration::searchBase(Loc loc, Identifier *ident)
 {
     // Search bases classes in depth-first, left to right order
@@ -1273,6 +1295,7 @@ void InterfaceDeclaration::semantic(Scope *sc)
         if (sizeok == SIZEOKdone || !scx)
         {
             semanticRun = PASSsemanticdone;
+            Module::wakeDeferredSemantic(this);
             return;
         }
     }
@@ -1322,6 +1345,8 @@ void InterfaceDeclaration::semantic(Scope *sc)
         if (!baseclasses->dim && sc->linkage == LINKcpp)
             cpp = true;
 
+        ClassDeclaration *waitingOn = NULL;   // first base not done yet
+
         // Check for errors, handle forward references
         for (size_t i = 0; i < baseclasses->dim; )
         {
@@ -1375,6 +1400,8 @@ void InterfaceDeclaration::semantic(Scope *sc)
                 //printf("\ttry later, forward reference of base %s\n", tc->sym->toChars());
                 if (tc->sym->scope)
                     tc->sym->scope->module->addDeferredSemantic(tc->sym);
+                if (!waitingOn)
+                    waitingOn = tc->sym;
                 doAncestorsSemantic = SemanticStart;
             }
             i++;
@@ -1384,10 +1411,11 @@ void InterfaceDeclaration::semantic(Scope *sc)
             // Forward referencee of one or more bases, try again later
             scope = scx ? scx : sc->copy();
             scope->setNoFree();
-            scope->module->addDeferredSemantic(this);
+            scope->module->addDeferredSemantic(this, waitingOn);
             return;
         }
         doAncestorsSemantic = SemanticDone;
+        Module::wakeDeferredSemantic(this);
 
         interfaces_dim = baseclasses->dim;
         interfaces = baseclasses->tdata();
@@ -1408,10 +1436,11 @@ Lancestorsdone:
     if (!members)               // if opaque declaration
     {
         semanticRun = PASSsemanticdone;
+        Module::wakeDeferredSemantic(this);
         return;
     }
     if (!symtab)
-        symtab = new DsymbolTable();
+        symtab = new DsymbolTable(members->dim);
 
     for (size_t i = 0; i < baseclasses->dim; i++)
     {
@@ -1427,7 +1456,7 @@ Lancestorsdone:
             scope->setNoFree();
             if (tc->sym->scope)
                 tc->sym->scope->module->addDeferredSemantic(tc->sym);
-            scope->module->addDeferredSemantic(this);
+            scope->module->addDeferredSemantic(this, tc->sym);
             return;
         }
     }
@@ -1522,6 +1551,7 @@ Lancestorsdone:
     }
 
     semanticRun = PASSsemanticdone;
+    Module::wakeDeferredSemantic(this);
 
     if (global.errors != errors)
     {
@@ -31,6 +31,30 @@ struct CtfeStatus
     static int maxCallDepth; // highest number of recursive calls
     static int numArrayAllocs; // Number of allocated arrays
     static int numAssignments; // total number of assignments executed
+    static size_t numNodes; // total number of Expression nodes allocated
+};
+
+/**
+  The Expression nodes created while interpreting are allocated from a
+  region, which is released as a whole when ctfeInterpret() is done with
+  it. Only the result is copied out, so compile time memory is bounded by
+  the largest single evaluation rather than by the sum of all of them.
+  Regions nest, and are suspended by CtfeRegionSuspend.
+ */
+struct CtfeRegion
+{
+    static bool active;         // Expression's are allocated from the region
+
+    CtfeRegion();               // start a region on top of the current one
+    Expression *release(Expression *result);
+    static Expression *copyOut(Expression *e);
+    static void *alloc(size_t size);
+    static bool contains(void *p);
+
+private:
+    size_t chunk;               // chunks in use when the region started
+    char *ptr;                  // and allocation pointer
+    bool wasActive;
 };
 
 /**
@@ -53,6 +77,10 @@ public:
     void accept(Visitor *v) { v->visit(this); }
 };
 
+/// Call fd with interpreted arguments using bytecode (-ctfe=bytecode), allowing
+/// at most maxdepth nested calls. Return NULL if it has to be interpreted instead.
+Expression *bcInterpret(FuncDeclaration *fd, Expressions *arguments, int maxdepth);
+
 // The various functions are used only to detect compiler CTFE bugs
 Expression *getValue(VarDeclaration *vd);
 bool hasValue(VarDeclaration *vd);
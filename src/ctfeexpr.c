@@ -16,6 +16,7 @@
 #include <new>
 
 #include "rmem.h"
+#include "aav.h"
 
 #include "expression.h"
 #include "declaration.h"
@@ -187,6 +188,274 @@ char *CTFEExp::toChars()
     }
 }
 
+/********************** CtfeRegion ******************************************/
+
+/* Set to 1 to have released chunks made inaccessible instead of reused,
+ * so that anything still pointing into them faults right away.
+ */
+#define CTFE_REGION_CHECK 0
+
+#if CTFE_REGION_CHECK
+#include <sys/mman.h>
+#endif
+
+#define CTFE_REGION_CHUNK  (1024 * 1024)
+#define CTFE_REGION_ALIGN  16
+
+struct CtfeRegionChunk
+{
+    char *start;
+    size_t size;
+};
+
+bool CtfeRegion::active;
+
+static Array<CtfeRegionChunk> regionChunks;     // chunks in use, oldest first
+static Array<char *> regionSpare;               // unused chunks of CTFE_REGION_CHUNK bytes
+static char *regionPtr;                         // next free byte in last chunk
+static char *regionEnd;                         // end of last chunk
+static Array<CtfeRegionChunk> regionSorted;     // regionChunks sorted by address
+static bool regionSortedValid;
+
+static char *newChunk(size_t size)
+{
+#if CTFE_REGION_CHECK
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (p == MAP_FAILED)
+        mem.error();
+    return (char *)p;
+#else
+    if (size == CTFE_REGION_CHUNK && regionSpare.dim)
+        return regionSpare.pop();
+    return (char *)mem.malloc(size);
+#endif
+}
+
+static void freeChunk(CtfeRegionChunk *c)
+{
+#if CTFE_REGION_CHECK
+    mprotect(c->start, c->size, PROT_NONE);
+#else
+    if (c->size == CTFE_REGION_CHUNK)
+        regionSpare.push(c->start);
+    else
+        mem.free(c->start);
+#endif
+}
+
+CtfeRegion::CtfeRegion()
+{
+    chunk = regionChunks.dim;
+    ptr = regionPtr;
+    wasActive = active;
+    active = true;
+#if CTFE_REGION_CHECK
+    regionPtr = regionEnd;      // so nothing below the mark gets reused
+#endif
+}
+
+void *CtfeRegion::alloc(size_t size)
+{
+    CtfeStatus::numNodes++;
+    size = (size + CTFE_REGION_ALIGN - 1) & ~(size_t)(CTFE_REGION_ALIGN - 1);
+    if (size > (size_t)(regionEnd - regionPtr))
+    {
+        // Large nodes get a chunk of their own
+        size_t chunksize = size > CTFE_REGION_CHUNK / 4 ? size : CTFE_REGION_CHUNK;
+        CtfeRegionChunk c;
+        c.start = newChunk(chunksize);
+        c.size = chunksize;
+        regionChunks.push(c);
+        regionSortedValid = false;
+        regionPtr = c.start;
+        regionEnd = c.start + chunksize;
+    }
+    void *p = regionPtr;
+    regionPtr += size;
+    return p;
+}
+
+static int chunkCmp(const void *p1, const void *p2)
+{
+    char *s1 = ((const CtfeRegionChunk *)p1)->start;
+    char *s2 = ((const CtfeRegionChunk *)p2)->start;
+    return s1 < s2 ? -1 : s1 > s2;
+}
+
+bool CtfeRegion::contains(void *p)
+{
+    if (!regionSortedValid)
+    {
+        regionSorted.setDim(regionChunks.dim);
+        if (regionChunks.dim)
+        {
+            memcpy(regionSorted.tdata(), regionChunks.tdata(), regionChunks.dim * sizeof(CtfeRegionChunk));
+            qsort(regionSorted.tdata(), regionSorted.dim, sizeof(CtfeRegionChunk), &chunkCmp);
+        }
+        regionSortedValid = true;
+    }
+    size_t lo = 0;
+    size_t hi = regionSorted.dim;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        CtfeRegionChunk *c = &regionSorted[mid];
+        if ((char *)p < c->start)
+            hi = mid;
+        else if ((char *)p >= c->start + c->size)
+            lo = mid + 1;
+        else
+            return true;
+    }
+    return false;
+}
+
+/* Copies an expression and everything it refers to out of the region,
+ * preserving sharing (class references, pointers into struct literals).
+ */
+class RegionCopier : public Visitor
+{
+public:
+    AA *copies;                 // Expression in region => its copy
+
+    RegionCopier() : copies(NULL) { }
+
+    Expression *copy(Expression *e)
+    {
+        if (!e || !CtfeRegion::contains(e))
+            return e;
+        Expression **pe = (Expression **)dmd_aaGet(&copies, e);
+        if (!*pe)
+        {
+            *pe = e->copy();
+            (*pe)->accept(this);
+        }
+        return *pe;
+    }
+
+    Expressions *copy(Expressions *a)
+    {
+        if (!a)
+            return NULL;
+        Expressions *b = new Expressions();
+        b->setDim(a->dim);
+        for (size_t i = 0; i < a->dim; i++)
+            (*b)[i] = copy((*a)[i]);
+        return b;
+    }
+
+    void visit(Expression *e)
+    {
+    }
+
+    void visit(UnaExp *e)
+    {
+        e->e1 = copy(e->e1);
+    }
+
+    void visit(BinExp *e)
+    {
+        e->e1 = copy(e->e1);
+        e->e2 = copy(e->e2);
+    }
+
+    void visit(CondExp *e)
+    {
+        e->econd = copy(e->econd);
+        visit((BinExp *)e);
+    }
+
+    void visit(SliceExp *e)
+    {
+        e->e1 = copy(e->e1);
+        e->lwr = copy(e->lwr);
+        e->upr = copy(e->upr);
+    }
+
+    void visit(CallExp *e)
+    {
+        e->e1 = copy(e->e1);
+        e->arguments = copy(e->arguments);
+    }
+
+    void visit(TupleExp *e)
+    {
+        e->e0 = copy(e->e0);
+        e->exps = copy(e->exps);
+    }
+
+    void visit(ArrayLiteralExp *e)
+    {
+        e->elements = copy(e->elements);
+    }
+
+    void visit(AssocArrayLiteralExp *e)
+    {
+        e->keys = copy(e->keys);
+        e->values = copy(e->values);
+    }
+
+    void visit(StructLiteralExp *e)
+    {
+        e->elements = copy(e->elements);
+        e->origin = (StructLiteralExp *)copy(e->origin);
+        e->inlinecopy = (StructLiteralExp *)copy(e->inlinecopy);
+    }
+
+    void visit(ClassReferenceExp *e)
+    {
+        e->value = (StructLiteralExp *)copy(e->value);
+    }
+
+    void visit(ThrownExceptionExp *e)
+    {
+        e->thrown = (ClassReferenceExp *)copy(e->thrown);
+    }
+
+    void visit(TypeidExp *e)
+    {
+        if (Expression *ea = isExpression(e->obj))
+            e->obj = copy(ea);
+    }
+};
+
+/* Return e, copied out of the region if needed
+ */
+Expression *CtfeRegion::copyOut(Expression *e)
+{
+    CtfeRegionSuspend suspend;
+    RegionCopier rc;
+    return rc.copy(e);
+}
+
+/* Copy the result out and free what the region allocated
+ */
+Expression *CtfeRegion::release(Expression *result)
+{
+    active = false;
+    result = copyOut(result);
+
+    for (size_t i = chunk; i < regionChunks.dim; i++)
+        freeChunk(&regionChunks[i]);
+    regionChunks.setDim(chunk);
+    regionSortedValid = false;
+    regionPtr = ptr;
+    regionEnd = chunk ? regionChunks[chunk - 1].start + regionChunks[chunk - 1].size : NULL;
+    active = wasActive;
+    return result;
+}
+
+CtfeRegionSuspend::CtfeRegionSuspend()
+{
+    wasActive = CtfeRegion::active;
+    CtfeRegion::active = false;
+}
+
+CtfeRegionSuspend::~CtfeRegionSuspend()
+{
+    CtfeRegion::active = wasActive;
+}
+
 Expression *UnionExp::copy()
 {
     Expression *e = exp();
@@ -179,6 +179,15 @@ Dsymbol *Declaration::search(Loc loc, Identifier *ident, int flags)
     return s;
 }
 
+void Declaration::addSpellings(Speller *sp)
+{
+    if (type)
+    {
+        if (Dsymbol *s = type->toDsymbol(scope))
+            s->showSpellings(sp);
+    }
+}
+
 
 /********************************* TupleDeclaration ****************************/
 
@@ -2305,6 +2314,7 @@ Expression *VarDeclaration::getConstInitializer(bool needFullType)
 
     if (scope)
     {
+        CtfeRegionSuspend suspend;
         inuse++;
         init = init->semantic(scope, type, INITinterpret);
         scope = NULL;
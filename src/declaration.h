@@ -30,6 +30,7 @@ class ExpInitializer;
 class StructDeclaration;
 struct InterState;
 struct CompiledCtfeFunction;
+struct BCFunction;
 
 enum LINK;
 enum TOK;
@@ -135,6 +136,7 @@ public:
     int checkModify(Loc loc, Scope *sc, Type *t, Expression *e1, int flag);
 
     Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
+    void addSpellings(Speller *sp);
 
     bool isStatic() { return (storage_class & STCstatic) != 0; }
     virtual bool isDelete();
@@ -550,6 +552,7 @@ public:
     ILS inlineStatusExp;
 
     CompiledCtfeFunction *ctfeCode;     // Compiled code for interpreter
+    BCFunction *ctfeBytecode;           // Compiled bytecode for -ctfe=bytecode
     int inlineNest;                     // !=0 if nested inline
     bool isArrayOp;                     // true if array operation
     bool semantic3Errors;               // true if errors in semantic3
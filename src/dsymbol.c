@@ -439,7 +439,25 @@ Dsymbol *Dsymbol::search_correct(Identifier *ident)
     if (global.gag)
         return NULL;            // don't do it for speculative compiles; too time consuming
 
-    return (Dsymbol *)speller(ident->toChars(), &symbol_search_fp, (void *)this, idchars);
+    Speller sp(ident->toChars(), &symbol_search_fp, (void *)this);
+    showSpellings(&sp);
+    return (Dsymbol *)sp.result();
+}
+
+/***************************************************
+ * Show sp the names search() could find, to look for
+ * a correct spelling among them. Each symbol is only
+ * shown once.
+ */
+
+void Dsymbol::showSpellings(Speller *sp)
+{
+    if (sp->visit(this))
+        addSpellings(sp);
+}
+
+void Dsymbol::addSpellings(Speller *sp)
+{
 }
 
 /***************************************
@@ -638,6 +656,8 @@ int Dsymbol::addMember(Scope *sc, ScopeDsymbol *sds, int memnum)
 
 void Dsymbol::error(const char *format, ...)
 {
+    if (global.gagError())
+        return;                 // don't pay for toPrettyChars()
     va_list ap;
     va_start(ap, format);
     ::verror(getLoc(), format, ap, kind(), toPrettyChars());
@@ -646,6 +666,8 @@ void Dsymbol::error(const char *format, ...)
 
 void Dsymbol::error(Loc loc, const char *format, ...)
 {
+    if (global.gagError())
+        return;
     va_list ap;
     va_start(ap, format);
     ::verror(loc, format, ap, kind(), toPrettyChars());
@@ -1010,6 +1032,17 @@ Dsymbol *ScopeDsymbol::search(Loc loc, Identifier *ident, int flags)
     return s1;
 }
 
+void ScopeDsymbol::addSpellings(Speller *sp)
+{
+    if (symtab)
+        sp->check(symtab->spellerIndex());
+    if (imports)
+    {
+        for (size_t i = 0; i < imports->dim; i++)
+            (*imports)[i]->showSpellings(sp);
+    }
+}
+
 OverloadSet *ScopeDsymbol::mergeOverloadSet(OverloadSet *os, Dsymbol *s)
 {
     if (!os)
@@ -1077,7 +1110,10 @@ void ScopeDsymbol::importScope(Dsymbol *s, Prot protection)
                 if (ss == s)                    // if already imported
                 {
                     if (protection.kind > prots[i])
+                    {
                         prots[i] = protection.kind;  // upgrade access
+                        Module::clearCache();
+                    }
                     return;
                 }
             }
@@ -1085,6 +1121,7 @@ void ScopeDsymbol::importScope(Dsymbol *s, Prot protection)
         imports->push(s);
         prots = (PROTKIND *)mem.realloc(prots, imports->dim * sizeof(prots[0]));
         prots[imports->dim - 1] = protection.kind;
+        Module::clearCache();
     }
 }
 
@@ -1123,6 +1160,9 @@ const char *ScopeDsymbol::kind()
 
 Dsymbol *ScopeDsymbol::symtabInsert(Dsymbol *s)
 {
+    // Namespaces and mixins are searched through by the scopes they're imported into
+    if (isNspace() || isTemplateMixin())
+        Module::clearCache();
     return symtab->insert(s);
 }
 
@@ -1307,6 +1347,25 @@ Dsymbol *WithScopeSymbol::search(Loc loc, Identifier *ident, int flags)
     return NULL;
 }
 
+void WithScopeSymbol::addSpellings(Speller *sp)
+{
+    // The same symbols search() looks in
+    Expression *eold = NULL;
+    for (Expression *e = withstate->exp; e != eold; e = resolveAliasThis(scope, e))
+    {
+        Dsymbol *s;
+        if (e->op == TOKimport)
+            s = ((ScopeExp *)e)->sds;
+        else if (e->op == TOKtype)
+            s = e->type->toDsymbol(NULL);
+        else
+            s = e->type->toBasetype()->toDsymbol(NULL);
+        if (s)
+            s->showSpellings(sp);
+        eold = e;
+    }
+}
+
 /****************************** ArrayScopeSymbol ******************************/
 
 ArrayScopeSymbol::ArrayScopeSymbol(Scope *sc, Expression *e)
@@ -1522,22 +1581,46 @@ Dsymbol *ArrayScopeSymbol::search(Loc loc, Identifier *ident, int flags)
 
 /****************************** DsymbolTable ******************************/
 
-DsymbolTable::DsymbolTable()
+DsymbolTable::DsymbolTable(size_t dim)
+    : tab(dim)
+{
+    spellindex = NULL;
+    spelllen = 0;
+}
+
+static void addSpelling(void *arg, void *key, void *value)
 {
-    tab = NULL;
+    if (key)                    // anonymous imports are in the table, too
+        ((SpellerIndex *)arg)->add(((Identifier *)key)->toChars());
+}
+
+SpellerIndex *DsymbolTable::spellerIndex()
+{
+    /* Rebuild it if symbols were added since. Compare with the length
+     * of the table, not of the index, which leaves out anonymous imports.
+     */
+    size_t len = tab.length();
+    if (!spellindex)
+        spellindex = new SpellerIndex();
+    else if (spelllen == len)
+        return spellindex;
+    spellindex->reset();
+    tab.apply(&addSpelling, spellindex);
+    spelllen = len;
+    return spellindex;
 }
 
 Dsymbol *DsymbolTable::lookup(Identifier *ident)
 {
     //printf("DsymbolTable::lookup(%s)\n", (char*)ident->string);
-    return (Dsymbol *)dmd_aaGetRvalue(tab, (void *)ident);
+    return (Dsymbol *)tab.getRvalue((void *)ident);
 }
 
 Dsymbol *DsymbolTable::insert(Dsymbol *s)
 {
     //printf("DsymbolTable::insert(this = %p, '%s')\n", this, s->ident->toChars());
     Identifier *ident = s->ident;
-    Dsymbol **ps = (Dsymbol **)dmd_aaGet(&tab, (void *)ident);
+    Dsymbol **ps = (Dsymbol **)tab.get((void *)ident);
     if (*ps)
         return NULL;            // already in table
     *ps = s;
@@ -1547,7 +1630,7 @@ Dsymbol *DsymbolTable::insert(Dsymbol *s)
 Dsymbol *DsymbolTable::insert(Identifier *ident, Dsymbol *s)
 {
     //printf("DsymbolTable::insert()\n");
-    Dsymbol **ps = (Dsymbol **)dmd_aaGet(&tab, (void *)ident);
+    Dsymbol **ps = (Dsymbol **)tab.get((void *)ident);
     if (*ps)
         return NULL;            // already in table
     *ps = s;
@@ -1557,7 +1640,7 @@ Dsymbol *DsymbolTable::insert(Identifier *ident, Dsymbol *s)
 Dsymbol *DsymbolTable::update(Dsymbol *s)
 {
     Identifier *ident = s->ident;
-    Dsymbol **ps = (Dsymbol **)dmd_aaGet(&tab, (void *)ident);
+    Dsymbol **ps = (Dsymbol **)tab.get((void *)ident);
     *ps = s;
     return s;
 }
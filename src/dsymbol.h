@@ -18,6 +18,7 @@
 
 #include "root.h"
 #include "stringtable.h"
+#include "aav.h"
 
 #include "mars.h"
 #include "arraytypes.h"
@@ -74,6 +75,8 @@ class Expression;
 class DeleteDeclaration;
 class OverloadSet;
 struct AA;
+struct Speller;
+struct SpellerIndex;
 #ifdef IN_GCC
 typedef union tree_node TYPE;
 #else
@@ -204,6 +207,8 @@ public:
     virtual void semantic3(Scope *sc);
     virtual Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
     Dsymbol *search_correct(Identifier *id);
+    void showSpellings(Speller *sp);
+    virtual void addSpellings(Speller *sp);
     Dsymbol *searchX(Loc loc, Scope *sc, RootObject *id);
     virtual bool overloadInsert(Dsymbol *s);
     virtual unsigned size(Loc loc);
@@ -298,6 +303,7 @@ public:
     ScopeDsymbol(Identifier *id);
     Dsymbol *syntaxCopy(Dsymbol *s);
     Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
+    void addSpellings(Speller *sp);
     OverloadSet *mergeOverloadSet(OverloadSet *os, Dsymbol *s);
     void importScope(Dsymbol *s, Prot protection);
     bool isforwardRef();
@@ -326,6 +332,7 @@ public:
 
     WithScopeSymbol(WithStatement *withstate);
     Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
+    void addSpellings(Speller *sp);
 
     WithScopeSymbol *isWithScopeSymbol() { return this; }
     void accept(Visitor *v) { v->visit(this); }
@@ -369,9 +376,12 @@ public:
 class DsymbolTable : public RootObject
 {
 public:
-    AA *tab;
+    FlatAA tab;
+    SpellerIndex *spellindex;   // names in tab, built when needed
+    size_t spelllen;            // tab.length() when spellindex was built
 
-    DsymbolTable();
+    // dim is how many symbols the table is expected to hold
+    DsymbolTable(size_t dim = 0);
 
     // Look up Identifier. Return Dsymbol if found, NULL if not.
     Dsymbol *lookup(Identifier *ident);
@@ -382,6 +392,9 @@ public:
     // Look for Dsymbol in table. If there, return it. If not, insert s and return that.
     Dsymbol *update(Dsymbol *s);
     Dsymbol *insert(Identifier *ident, Dsymbol *s);     // when ident and s are not the same
+
+    // Names in table, to look for correct spellings in.
+    SpellerIndex *spellerIndex();
 };
 
 #endif /* DMD_DSYMBOL_H */
@@ -77,7 +77,7 @@ int EnumDeclaration::addMember(Scope *sc, ScopeDsymbol *sds, int memnum)
         ScopeDsymbol::addMember(sc, sds, memnum);
 
         if (!symtab)
-            symtab = new DsymbolTable();
+            symtab = new DsymbolTable(members ? members->dim : 0);
     }
 
     if (members)
@@ -136,7 +136,7 @@ void EnumDeclaration::semantic(Scope *sc)
     }
 
     if (!symtab)
-        symtab = new DsymbolTable();
+        symtab = new DsymbolTable(members ? members->dim : 0);
 
     /* The separate, and distinct, cases are:
      *  1. enum { ... }
@@ -160,7 +160,7 @@ void EnumDeclaration::semantic(Scope *sc)
                 // memtype is forward referenced, so try again later
                 scope = scx ? scx : sc->copy();
                 scope->setNoFree();
-                scope->module->addDeferredSemantic(this);
+                scope->module->addDeferredSemantic(this, sym);
                 Module::dprogress = dprogress_save;
                 //printf("\tdeferring %s\n", toChars());
                 semanticRun = PASSinit;
@@ -200,8 +200,6 @@ void EnumDeclaration::semantic(Scope *sc)
         return;
     }
 
-    Module::dprogress++;
-
     Scope *sce;
     if (isAnonymous())
         sce = sc;
@@ -268,6 +266,12 @@ void EnumDeclaration::semantic(Scope *sc)
         if (em)
             em->semantic(em->scope);
     }
+
+    /* Only now is memtype known for an enum without a base type,
+     * and so are its members, so only now can what waits on it go on.
+     */
+    Module::dprogress++;
+    Module::wakeDeferredSemantic(this);
     //printf("defaultval = %lld\n", defaultval);
 
     //if (defaultval) printf("defaultval: %s %s\n", defaultval->toChars(), defaultval->type->toChars());
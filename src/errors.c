@@ -144,6 +144,18 @@ void warning(Loc loc, const char *format, ...)
     va_end( ap );
 }
 
+void warning(const char *filename, unsigned linnum, unsigned charnum, const char *format, ...)
+{
+    Loc loc;
+    loc.filename = (char *)filename;
+    loc.linnum = linnum;
+    loc.charnum = charnum;
+    va_list ap;
+    va_start(ap, format);
+    vwarning(loc, format, ap);
+    va_end( ap );
+}
+
 void warningSupplemental(Loc loc, const char *format, ...)
 {
     va_list ap;
@@ -200,7 +212,9 @@ void verror(Loc loc, const char *format, va_list ap,
                 const char *p1, const char *p2, const char *header)
 {
     global.errors++;
-    if (!global.gag)
+    if (!global.gag && global.quiet)
+        global.quietErrors++;
+    else if (!global.gag)
     {
         verrorPrint(loc, COLOR_RED, header, format, ap, p1, p2);
         if (global.errorLimit && global.errors >= global.errorLimit)
@@ -217,7 +231,7 @@ void verror(Loc loc, const char *format, va_list ap,
 // Doesn't increase error count, doesn't print "Error:".
 void verrorSupplemental(Loc loc, const char *format, va_list ap)
 {
-    if (!global.gag)
+    if (!global.gag && !global.quiet)
         verrorPrint(loc, COLOR_RED, "       ", format, ap);
 }
 
@@ -225,16 +239,21 @@ void vwarning(Loc loc, const char *format, va_list ap)
 {
     if (global.params.warnings && !global.gag)
     {
-        verrorPrint(loc, COLOR_YELLOW, "Warning: ", format, ap);
+        if (!global.quiet)
+            verrorPrint(loc, COLOR_YELLOW, "Warning: ", format, ap);
 //halt();
         if (global.params.warnings == 1)
+        {
             global.warnings++;  // warnings don't count if gagged
+            if (global.quiet)
+                global.quietErrors++;
+        }
     }
 }
 
 void vwarningSupplemental(Loc loc, const char *format, va_list ap)
 {
-    if (global.params.warnings && !global.gag)
+    if (global.params.warnings && !global.gag && !global.quiet)
         verrorPrint(loc, COLOR_YELLOW, "       ", format, ap);
 }
 
@@ -244,7 +263,7 @@ void vdeprecation(Loc loc, const char *format, va_list ap,
     static const char *header = "Deprecation: ";
     if (global.params.useDeprecated == 0)
         verror(loc, format, ap, p1, p2, header);
-    else if (global.params.useDeprecated == 2 && !global.gag)
+    else if (global.params.useDeprecated == 2 && !global.gag && !global.quiet)
         verrorPrint(loc, COLOR_BLUE, header, format, ap, p1, p2);
 }
 
@@ -252,7 +271,7 @@ void vdeprecationSupplemental(Loc loc, const char *format, va_list ap)
 {
     if (global.params.useDeprecated == 0)
         verrorSupplemental(loc, format, ap);
-    else if (global.params.useDeprecated == 2 && !global.gag)
+    else if (global.params.useDeprecated == 2 && !global.gag && !global.quiet)
         verrorPrint(loc, COLOR_BLUE, "       ", format, ap);
 }
 
@@ -2007,6 +2007,13 @@ Expression *Expression::syntaxCopy()
  * Does *not* do a deep copy.
  */
 
+void *Expression::operator new(size_t size)
+{
+    if (CtfeRegion::active)
+        return CtfeRegion::alloc(size);
+    return ::operator new(size);
+}
+
 Expression *Expression::copy()
 {
     Expression *e;
@@ -2019,7 +2026,10 @@ Expression *Expression::copy()
 #endif
         assert(0);
     }
-    e = (Expression *)mem.malloc(size);
+    if (CtfeRegion::active)
+        e = (Expression *)CtfeRegion::alloc(size);
+    else
+        e = (Expression *)mem.malloc(size);
     //printf("Expression::copy(op = %d) e = %p\n", op, e);
     return (Expression *)memcpy((void*)e, (void*)this, size);
 }
@@ -3182,6 +3192,9 @@ Expression *IdentifierExp::semantic(Scope *sc)
         return e;
     }
 
+    if (global.gagError())
+        return new ErrorExp();  // no hints for speculative compiles
+
     const char *n = importHint(ident->toChars());
     if (n)
         error("'%s' is not defined, perhaps you need to import %s; ?", ident->toChars(), n);
@@ -5430,7 +5443,7 @@ void FuncExp::genIdent(Scope *sc)
             symtab = sds->symtab;
         }
         assert(symtab);
-        int num = (int)dmd_aaLen(symtab->tab) + 1;
+        int num = (int)symtab->tab.length() + 1;
         Identifier *id = Identifier::generateId(s, num);
         fd->ident = id;
         if (td) td->ident = id;
@@ -113,6 +113,19 @@ Expression *ctfeInterpretForPragmaMsg(Expression *e);
 #define WANTvalue   0   // default
 #define WANTexpand  1   // expand const/immutable variables if possible
 
+/* CTFE allocates Expression's from a region that is released when it is
+ * done (see CtfeRegion). Semantic analysis started from within CTFE creates
+ * nodes that have to outlive it, and puts one of these in scope while
+ * doing so to allocate them from the heap.
+ */
+struct CtfeRegionSuspend
+{
+    bool wasActive;
+
+    CtfeRegionSuspend();
+    ~CtfeRegionSuspend();
+};
+
 class Expression : public RootObject
 {
 public:
@@ -123,6 +136,8 @@ public:
     unsigned char parens;       // if this is a parenthesized expression
 
     Expression(Loc loc, TOK op, int size);
+    void *operator new(size_t size);
+    void *operator new(size_t size, void *p) { return p; }
     static void init();
     Expression *copy();
     virtual Expression *syntaxCopy();
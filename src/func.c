@@ -313,6 +313,7 @@ FuncDeclaration::FuncDeclaration(Loc loc, Loc endloc, Identifier *id, StorageCla
     inlineStatusStmt = ILSuninitialized;
     inlineNest = 0;
     ctfeCode = NULL;
+    ctfeBytecode = NULL;
     isArrayOp = 0;
     semantic3Errors = false;
     fes = NULL;
@@ -2202,6 +2203,8 @@ bool FuncDeclaration::functionSemantic()
     if (!scope)
         return true;
 
+    CtfeRegionSuspend suspend;  // may be called by CTFE
+
     if (!originalType)      // semantic not yet run
     {
         TemplateInstance *spec = isSpeculative();
@@ -2245,6 +2248,8 @@ bool FuncDeclaration::functionSemantic3()
 {
     if (semanticRun < PASSsemantic3 && scope)
     {
+        CtfeRegionSuspend suspend;  // may be called by CTFE
+
         /* Forward reference - we need to run semantic3 on this function.
          * If errors are gagged, and it's not part of a template instance,
          * we need to temporarily ungag errors.
@@ -3187,6 +3192,12 @@ FuncDeclaration *resolveFuncCall(Loc loc, Scope *sc, Dsymbol *s,
             return NULL;    // no match
     }
 
+    /* Speculative overload resolution fails often, don't build
+     * argument lists for messages that won't be printed.
+     */
+    if ((m.lastf ? m.nextf != NULL : !(flags & 1)) && global.gagError())
+        return NULL;
+
     FuncDeclaration *fd = s->isFuncDeclaration();
     TemplateDeclaration *td = s->isTemplateDeclaration();
     if (td && td->funcroot)
@@ -100,6 +100,15 @@ void Global::increaseErrorCount()
     ++errors;
 }
 
+bool Global::gagError()
+{
+    if (!gag)
+        return false;
+    ++gaggedErrors;
+    ++errors;
+    return true;
+}
+
 
 char *Loc::toChars()
 {
@@ -22,6 +22,14 @@
 // Can't include arraytypes.h here, need to declare these directly.
 template <typename TYPE> struct Array;
 
+// Processor optimized 64 bit code is scheduled for (-mcpu)
+enum CPU
+{
+    CPUbaseline,        // leave it in the order it is generated
+    CPUskylake,         // Intel Skylake
+    CPUzen,             // AMD Zen
+};
+
 // Put command line switches in here
 struct Param
 {
@@ -35,11 +43,15 @@ struct Param
     bool verbose;       // verbose compile
     bool showColumns;   // print character (column) numbers in diagnostics
     bool vtls;          // identify thread local variables
+    bool vtemplates;    // list template instantiation counts
+    bool vctfe;         // list cost of functions called by CTFE
     char vgc;           // identify gc usage
     bool vfield;        // identify non-mutable field variables
     char symdebug;      // insert debug symbolic information
     bool alwaysframe;   // always emit standard stack frame
     bool optimize;      // run optimizer
+    bool regColor;      // colour all register candidates in one pass
+    CPU cpu;            // processor to schedule 64 bit code for
     bool map;           // generate linker .map file
     bool is64bit;       // generate 64 bit code
     bool isLP64;        // generate code for LP64
@@ -64,6 +76,7 @@ struct Param
     bool useSwitchError; // check for switches without a default
     bool useUnitTests;  // generate unittest code
     bool useInline;     // inline expand functions
+    bool ctfeBytecode;  // run what CTFE it can as bytecode
     bool useDIP25;      // implement http://wiki.dlang.org/DIP25
     bool release;       // build release version
     bool preservePaths; // true means don't strip path from source file
@@ -80,6 +93,7 @@ struct Param
     bool betterC;       // be a "better C" compiler; no dependency on D runtime
     bool addMain;       // add a default main() function
     bool allInst;       // generate code for all template instantiations
+    unsigned jobs;      // number of parallel jobs for semantic analysis and code generation (-j)
 
     const char *argv0;    // program name
     Array<const char *> *imppath;     // array of char*'s of where to look for import modules
@@ -111,6 +125,11 @@ struct Param
 
     const char *moduleDepsFile; // filename for deps output
     OutBuffer *moduleDeps;      // contents to be written to deps file
+    const char *tokcachedir;    // directory for cached tokens of source files
+
+    bool timeTrace;             // write time spent in each phase (-ftime-trace)
+    const char *timeTraceFile;  // write it to timeTraceFile
+    unsigned timeTraceGranularity;      // leave out spans shorter than this many microseconds
 
     // Hidden debug switches
     bool debugb;
@@ -173,6 +192,8 @@ struct Global
     FILE *stdmsg;          // where to send verbose messages
     unsigned gag;          // !=0 means gag reporting of errors & warnings
     unsigned gaggedErrors; // number of errors reported while gagged
+    bool quiet;            // count errors & warnings, but leave printing them to another -j job
+    unsigned quietErrors;  // number of errors & warnings counted but not printed while quiet
 
     unsigned errorLimit;
 
@@ -191,6 +212,13 @@ struct Global
      */
     void increaseErrorCount();
 
+    /*  If errors are gagged, count an error and return true.
+     *  Gagged messages are never printed: when one matters, the
+     *  code is compiled again ungagged to reproduce it. So a caller
+     *  can skip building a message that is expensive to format.
+     */
+    bool gagError();
+
     void init();
 };
 
@@ -28,6 +28,7 @@
 #include "template.h"
 #include "lib.h"
 #include "target.h"
+#include "timetrace.h"
 
 #include "rmem.h"
 #include "cc.h"
@@ -842,6 +843,7 @@ void FuncDeclaration_toObjFile(FuncDeclaration *fd, bool multiobj)
 
     // start code generation
     fd->semanticRun = PASSobj;
+    TimeTraceScope trace("codegen function", fd);
 
     if (global.params.verbose)
         fprintf(global.stdmsg, "function  %s\n", fd->toPrettyChars());
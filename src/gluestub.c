@@ -75,6 +75,10 @@ void backend_term()
 {
 }
 
+void flowstats_print()
+{
+}
+
 // typinf
 
 Expression *getInternalTypeInfo(Type *t, Scope *sc)
@@ -83,7 +83,7 @@ int Identifier::dyncast()
     return DYNCAST_IDENTIFIER;
 }
 
-StringTable Identifier::stringtable;
+SharedStringTable Identifier::stringtable;
 
 Identifier *Identifier::generateId(const char *prefix)
 {
@@ -113,13 +113,19 @@ Identifier *Identifier::idPool(const char *s)
 
 Identifier *Identifier::idPool(const char *s, size_t len)
 {
-    StringValue *sv = stringtable.update(s, len);
+    return idPool(s, len, StringTable::calcHash(s, len));
+}
+
+/********************************************
+ * Same, with hash being StringTable::calcHash(s, len).
+ */
+
+Identifier *Identifier::idPool(const char *s, size_t len, hash_t hash)
+{
+    StringValue *sv = stringtable.update(s, len, hash);
     Identifier *id = (Identifier *) sv->ptrvalue;
     if (!id)
-    {
-        id = new Identifier(sv->toDchars(), TOKidentifier);
-        sv->ptrvalue = (char *)id;
-    }
+        id = (Identifier *)sv->initPtrvalue(new Identifier(sv->toDchars(), TOKidentifier));
     return id;
 }
 
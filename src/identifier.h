@@ -35,11 +35,12 @@ public:
     const char *toHChars2();
     int dyncast();
 
-    static StringTable stringtable;
+    static SharedStringTable stringtable;
     static Identifier *generateId(const char *prefix);
     static Identifier *generateId(const char *prefix, size_t i);
     static Identifier *idPool(const char *s);
     static Identifier *idPool(const char *s, size_t len);
+    static Identifier *idPool(const char *s, size_t len, hash_t hash);
     static Identifier *lookup(const char *s, size_t len);
     static void initTable();
 };
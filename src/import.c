@@ -189,6 +189,8 @@ void Import::importAll(Scope *sc)
         load(sc);
         if (mod)                // if successfully loaded module
         {
+            sc->module->importedAll.push(mod);
+
             if (mod->md && mod->md->isdeprecated)
             {
                 Expression *msg = mod->md->msg;
@@ -440,6 +442,12 @@ Dsymbol *Import::search(Loc loc, Identifier *ident, int flags)
     return pkg->search(loc, ident, flags);
 }
 
+void Import::addSpellings(Speller *sp)
+{
+    if (pkg)
+        pkg->showSpellings(sp);
+}
+
 bool Import::overloadInsert(Dsymbol *s)
 {
     /* Allow multiple imports with the same package base, but disallow
@@ -59,6 +59,7 @@ public:
     Dsymbol *toAlias();
     int addMember(Scope *sc, ScopeDsymbol *sds, int memnum);
     Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
+    void addSpellings(Speller *sp);
     bool overloadInsert(Dsymbol *s);
 
     Import *isImport() { return this; }
@@ -15,6 +15,7 @@
 #include <string.h>                     // mem{cpy|set}()
 
 #include "rmem.h"
+#include "aav.h"
 
 #include "statement.h"
 #include "expression.h"
@@ -32,6 +33,7 @@
 #include "template.h"
 #include "port.h"
 #include "ctfe.h"
+#include "timetrace.h"
 
 /* Interpreter: what form of return value expression is required?
  */
@@ -85,12 +87,17 @@ private:
 
     size_t framepointer;      // current frame pointer
     size_t maxStackPointer;   // most stack we've ever used
+    size_t peakStackPointer;  // most stack used since setPeak()
     Expression *localThis;    // value of 'this', or NULL if none
 public:
     CtfeStack();
 
     size_t stackPointer();
 
+    // Largest stack pointer since the last setPeak(), for -vctfe
+    size_t peak() { return peakStackPointer; }
+    void setPeak(size_t sp) { peakStackPointer = sp; }
+
     // The current value of 'this', or NULL if none
     Expression *getThis();
 
@@ -126,7 +133,7 @@ struct InterState
 
 CtfeStack ctfeStack;
 
-CtfeStack::CtfeStack() : framepointer(0), maxStackPointer(0)
+CtfeStack::CtfeStack() : framepointer(0), maxStackPointer(0), peakStackPointer(0)
 {
 }
 
@@ -204,6 +211,8 @@ void CtfeStack::push(VarDeclaration *v)
     v->ctfeAdrOnStack = (int)values.dim;
     vars.push(v);
     values.push(NULL);
+    if (values.dim > peakStackPointer)
+        peakStackPointer = values.dim;
 }
 
 void CtfeStack::pop(VarDeclaration *v)
@@ -239,7 +248,7 @@ void CtfeStack::saveGlobalConstant(VarDeclaration *v, Expression *e)
 {
      assert( v->init && (v->isConst() || v->isImmutable() || v->storage_class & STCmanifest) && !v->isCTFE());
      v->ctfeAdrOnStack = (int)globalValues.dim;
-     globalValues.push(e);
+     globalValues.push(CtfeRegion::copyOut(e));
 }
 
 /************** InterState  ********************************************/
@@ -256,6 +265,117 @@ int CtfeStatus::stackTraceCallsToSuppress = 0;
 int CtfeStatus::maxCallDepth = 0;
 int CtfeStatus::numArrayAllocs = 0;
 int CtfeStatus::numAssignments = 0;
+size_t CtfeStatus::numNodes = 0;
+
+/************** -vctfe ********************************************/
+
+/* Cost of the calls CTFE made to a function
+ */
+struct CtfeFuncStats
+{
+    FuncDeclaration *fd;
+    unsigned calls;
+    unsigned active;            // calls in progress, so recursion isn't counted twice
+    unsigned long long time;    // nanoseconds spent in calls
+    unsigned long long selftime; // not counting the functions it called
+    size_t nodes;               // Expression nodes allocated, not counting callees
+    size_t maxstack;            // most CtfeStack slots used by a call and its callees
+};
+
+static AA *ctfeFuncStatsMap;    // FuncDeclaration* => CtfeFuncStats*
+static Array<CtfeFuncStats *> ctfeFuncStats;
+
+/* Measures one call, for as long as it is in scope
+ */
+struct CtfeProfile
+{
+    CtfeProfile *caller;
+    CtfeFuncStats *stats;
+    unsigned long long start;
+    unsigned long long childtime;
+    size_t startnodes;
+    size_t childnodes;
+    size_t startsp;
+    size_t callerpeak;
+
+    static CtfeProfile *current;
+
+    CtfeProfile(FuncDeclaration *fd)
+    {
+        CtfeFuncStats **ps = (CtfeFuncStats **)dmd_aaGet(&ctfeFuncStatsMap, fd);
+        if (!*ps)
+        {
+            *ps = new CtfeFuncStats();
+            memset(*ps, 0, sizeof(CtfeFuncStats));
+            (*ps)->fd = fd;
+            ctfeFuncStats.push(*ps);
+        }
+        stats = *ps;
+        stats->calls++;
+        stats->active++;
+        caller = current;
+        current = this;
+        childtime = 0;
+        childnodes = 0;
+        startnodes = CtfeStatus::numNodes;
+        startsp = ctfeStack.stackPointer();
+        callerpeak = ctfeStack.peak();
+        ctfeStack.setPeak(startsp);
+        start = Port::nanoseconds();
+    }
+
+    ~CtfeProfile()
+    {
+        unsigned long long time = Port::nanoseconds() - start;
+        size_t nodes = CtfeStatus::numNodes - startnodes;
+        if (--stats->active == 0)
+            stats->time += time;
+        stats->selftime += time - childtime;
+        stats->nodes += nodes - childnodes;
+        size_t used = ctfeStack.peak() - startsp;
+        if (used > stats->maxstack)
+            stats->maxstack = used;
+        if (callerpeak > ctfeStack.peak())
+            ctfeStack.setPeak(callerpeak);
+        current = caller;
+        if (caller)
+        {
+            caller->childtime += time;
+            caller->childnodes += nodes;
+        }
+    }
+};
+
+CtfeProfile *CtfeProfile::current;
+
+static int ctfeFuncStatsCmp(const void *p1, const void *p2)
+{
+    CtfeFuncStats *s1 = *(CtfeFuncStats **)p1;
+    CtfeFuncStats *s2 = *(CtfeFuncStats **)p2;
+    if (s1->time != s2->time)
+        return s1->time < s2->time ? 1 : -1;
+    return s1->calls < s2->calls ? 1 : s1->calls > s2->calls ? -1 : 0;
+}
+
+static void printCtfeFuncStats()
+{
+    if (!ctfeFuncStats.dim)
+        return;
+
+    qsort(ctfeFuncStats.tdata(), ctfeFuncStats.dim, sizeof(CtfeFuncStats *), &ctfeFuncStatsCmp);
+    for (size_t i = 0; i < ctfeFuncStats.dim; i++)
+    {
+        CtfeFuncStats *s = ctfeFuncStats[i];
+        char *p = s->fd->loc.toChars();
+        fprintf(global.stdmsg, "%s: vctfe: %u call(s) of '%s', %.3f ms (%.3f ms self), "
+            "%llu nodes, %llu stack slots\n",
+            p ? p : "", s->calls, s->fd->toPrettyChars(),
+            s->time / 1e6, s->selftime / 1e6,
+            (unsigned long long)s->nodes, (unsigned long long)s->maxstack);
+        if (p)
+            mem.free(p);
+    }
+}
 
 // CTFE diagnostic information
 void printCtfePerformanceStats()
@@ -265,6 +385,7 @@ void printCtfePerformanceStats()
     printf("max call depth = %d\tmax stack = %d\n", CtfeStatus::maxCallDepth, ctfeStack.maxStackUsage());
     printf("array allocs = %d\tassignments = %d\n\n", CtfeStatus::numArrayAllocs, CtfeStatus::numAssignments);
 #endif
+    printCtfeFuncStats();
 }
 
 VarDeclaration *findParentVar(Expression *e);
@@ -739,9 +860,11 @@ Expression *ctfeInterpret(Expression *e)
     ctfeCodeGlobal.callingloc = e->loc;
     ctfeCodeGlobal.onExpression(e);
 
+    CtfeRegion region;
     Expression *result = interpret(e, NULL);
     if (!CTFEExp::isCantExp(result))
         result = scrubReturnValue(e->loc, result);
+    result = region.release(result);
     if (CTFEExp::isCantExp(result))
     {
         assert(global.errors != olderrors);
@@ -811,7 +934,20 @@ Expression *ctfeInterpretForPragmaMsg(Expression *e)
  * or CTFEExp if function returned void.
  */
 
+static Expression *interpretFunction(FuncDeclaration *fd, InterState *istate, Expressions *arguments, Expression *thisarg);
+
 Expression *interpret(FuncDeclaration *fd, InterState *istate, Expressions *arguments, Expression *thisarg)
+{
+    TimeTraceScope trace("ctfe", fd);
+    if (global.params.vctfe)
+    {
+        CtfeProfile profile(fd);
+        return interpretFunction(fd, istate, arguments, thisarg);
+    }
+    return interpretFunction(fd, istate, arguments, thisarg);
+}
+
+static Expression *interpretFunction(FuncDeclaration *fd, InterState *istate, Expressions *arguments, Expression *thisarg)
 {
 #if LOG
     printf("\n********\n%s FuncDeclaration::interpret(istate = %p) %s\n", fd->loc.toChars(), istate, fd->toChars());
@@ -917,6 +1053,12 @@ Expression *interpret(FuncDeclaration *fd, InterState *istate, Expressions *argu
         eargs[i] = earg;
     }
 
+    if (global.params.ctfeBytecode && !thisarg)
+    {
+        if (Expression *e = bcInterpret(fd, &eargs, CTFE_RECURSION_LIMIT - CtfeStatus::callDepth))
+            return e;
+    }
+
     // Now that we've evaluated all the arguments, we can start the frame
     // (this is the moment when the 'call' actually takes place).
     InterState istatex;
@@ -2233,6 +2375,7 @@ public:
 
             if (!v->originalType && v->scope)   // semantic() not yet run
             {
+                CtfeRegionSuspend suspend;
                 v->semantic (v->scope);
                 if (v->type->ty == Terror)
                     return CTFEExp::cantexp;
@@ -2243,7 +2386,10 @@ public:
                 v->init && !v->isCTFE())
             {
                 if (v->scope && !v->inuse)
+                {
+                    CtfeRegionSuspend suspend;
                     v->init = v->init->semantic(v->scope, v->type, INITinterpret); // might not be run on aggregate members
+                }
                 {
                     e = v->init->toExpression(v->type);
                 }
@@ -27,6 +27,7 @@
 #include "utf.h"
 #include "identifier.h"
 #include "id.h"
+#include "tokcache.h"
 
 extern int HtmlNamedEntity(const utf8_t *p, size_t length);
 
@@ -62,6 +63,120 @@ static void cmtable_init()
     }
 }
 
+/********************************************
+ * Skip runs of bytes that need no more than p++, 16 at a time where
+ * SSE2 is available. They stop at end, which is followed by the 0
+ * that terminates the source, so they never read past the buffer.
+ */
+
+#if __SSE2__ || _M_X64 || _M_IX86_FP >= 2
+#define LEXER_SSE2 1
+#include <emmintrin.h>
+#if _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit of m, which is not 0
+static inline unsigned firstBit(unsigned m)
+{
+#if _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return i;
+#else
+    return __builtin_ctz(m);
+#endif
+}
+
+// Bytes of x that are in [lo .. hi]
+static inline __m128i inRange(__m128i x, unsigned char lo, unsigned char hi)
+{
+    // Move lo to -128, so an unsigned range check is a signed compare
+    __m128i y = _mm_add_epi8(x, _mm_set1_epi8((char)(0x80 - lo)));
+    return _mm_cmplt_epi8(y, _mm_set1_epi8((char)(0x80 + hi - lo + 1)));
+}
+#endif
+
+/* Skip ' ' and '\t'.
+ */
+static inline const utf8_t *skipBlanks(const utf8_t *p, const utf8_t *end)
+{
+#if LEXER_SSE2
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, tab));
+        unsigned bits = ~_mm_movemask_epi8(m) & 0xFFFF;
+        if (bits)
+            return p + firstBit(bits);
+    }
+#endif
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+/* Skip ASCII identifier characters, and mix each whole 4 of them
+ * into hash while they are at hand.
+ */
+static inline const utf8_t *skipIdChars(const utf8_t *p, const utf8_t *end, StringHash *hash)
+{
+#if LEXER_SSE2
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i underscore = _mm_set1_epi8('_');
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_or_si128(inRange(_mm_or_si128(x, lower), 'a', 'z'),
+                    _mm_or_si128(inRange(x, '0', '9'), _mm_cmpeq_epi8(x, underscore)));
+        unsigned bits = ~_mm_movemask_epi8(m) & 0xFFFF;
+        unsigned n = bits ? firstBit(bits) : 16;
+        for (unsigned i = 0; i + 4 <= n; i += 4)
+            hash->word((const char *)p + i);
+        if (bits)
+            return p + n;
+    }
+#endif
+    const utf8_t *q = p;
+    while (p < end && isidchar(*p))
+        p++;
+    for (; p - q >= 4; q += 4)
+        hash->word((const char *)q);
+    return p;
+}
+
+/* Skip the bytes of a comment or string up to the next one that is
+ * c1, c2, a control character (which takes in line ends and the end
+ * of the source), or not ASCII.
+ */
+static inline const utf8_t *skipPlain(const utf8_t *p, const utf8_t *end, utf8_t c1, utf8_t c2)
+{
+#if LEXER_SSE2
+    const __m128i control = _mm_set1_epi8(0x20);
+    const __m128i v1 = _mm_set1_epi8((char)c1);
+    const __m128i v2 = _mm_set1_epi8((char)c2);
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        // As a signed compare, this is also true for bytes >= 0x80
+        __m128i m = _mm_or_si128(_mm_cmplt_epi8(x, control),
+                    _mm_or_si128(_mm_cmpeq_epi8(x, v1), _mm_cmpeq_epi8(x, v2)));
+        unsigned bits = _mm_movemask_epi8(m);
+        if (bits)
+            return p + firstBit(bits);
+    }
+#endif
+    for (; p < end; p++)
+    {
+        utf8_t c = *p;
+        if (c < 0x20 || c >= 0x80 || c == c1 || c == c2)
+            break;
+    }
+    return p;
+}
+
 /*************************** Lexer ********************************************/
 
 OutBuffer Lexer::stringbuffer;
@@ -82,6 +197,7 @@ Lexer::Lexer(const char *filename,
     this->anyToken = 0;
     this->commentToken = commentToken;
     this->errors = false;
+    this->tokcache = NULL;
     //initKeywords();
 
     /* If first line starts with '#!', ignore the line
@@ -172,6 +288,10 @@ TOK Lexer::nextToken()
         memcpy(&token,t,sizeof(Token));
         t->free();
     }
+    else if (tokcache)
+    {
+        tokcache->scan(this, &token);
+    }
     else
     {
         scan(&token);
@@ -188,7 +308,10 @@ Token *Lexer::peek(Token *ct)
     else
     {
         t = Token::alloc();
-        scan(t);
+        if (tokcache)
+            tokcache->scan(this, t);
+        else
+            scan(t);
         ct->next = t;
     }
     return t;
@@ -325,6 +448,9 @@ void Lexer::scan(Token *t)
 
             case ' ':
             case '\t':
+                p = skipBlanks(p + 1, end);
+                continue;                       // skip white space
+
             case '\v':
             case '\f':
                 p++;
@@ -400,24 +526,33 @@ void Lexer::scan(Token *t)
             case '_':
             case_ident:
             {   utf8_t c;
+                StringHash hash;
+                bool hashed = p == t->ptr;      // hashed from the start, 4 bytes at a time
 
+                hash.init();
                 while (1)
                 {
-                    c = *++p;
-                    if (isidchar(c))
-                        continue;
-                    else if (c & 0x80)
+                    p = skipIdChars(p, end, &hash);
+                    c = *p;
+                    if (c & 0x80)
                     {   const utf8_t *s = p;
                         unsigned u = decodeUTF();
                         if (isUniAlpha(u))
+                        {
+                            hashed = false;
+                            p++;
                             continue;
+                        }
                         error("char 0x%04x not allowed in identifier", u);
                         p = s;
                     }
                     break;
                 }
 
-                Identifier *id = Identifier::idPool((char *)t->ptr, p - t->ptr);
+                size_t len = p - t->ptr;
+                Identifier *id = Identifier::idPool((char *)t->ptr, len,
+                    hashed ? hash.finish((char *)t->ptr + (len & ~3), len & 3, len)
+                           : StringTable::calcHash((char *)t->ptr, len));
                 t->ident = id;
                 t->value = (TOK) id->value;
                 anyToken = 1;
@@ -514,7 +649,8 @@ void Lexer::scan(Token *t)
                         while (1)
                         {
                             while (1)
-                            {   utf8_t c = *p;
+                            {   p = skipPlain(p, end, '/', '/');
+                                utf8_t c = *p;
                                 switch (c)
                                 {
                                     case '/':
@@ -569,7 +705,8 @@ void Lexer::scan(Token *t)
                     case '/':           // do // style comments
                         startLoc = loc();
                         while (1)
-                        {   utf8_t c = *++p;
+                        {   p = skipPlain(p + 1, end, '\n', '\n');
+                            utf8_t c = *p;
                             switch (c)
                             {
                                 case '\n':
@@ -629,7 +766,8 @@ void Lexer::scan(Token *t)
                         p++;
                         nest = 1;
                         while (1)
-                        {   utf8_t c = *p;
+                        {   p = skipPlain(p, end, '/', '+');
+                            utf8_t c = *p;
                             switch (c)
                             {
                                 case '/':
@@ -972,7 +1110,10 @@ void Lexer::scan(Token *t)
 
                     // Check for start of unicode identifier
                     if (isUniAlpha(c))
+                    {
+                        p++;
                         goto case_ident;
+                    }
 
                     if (c == PS || c == LS)
                     {
@@ -1127,6 +1268,10 @@ TOK Lexer::wysiwygStringConstant(Token *t, int tc)
     stringbuffer.reset();
     while (1)
     {
+        const utf8_t *q = skipPlain(p, end, tc, tc);
+        stringbuffer.write(p, q - p);
+        p = q;
+
         c = *p++;
         switch (c)
         {
@@ -1484,6 +1629,10 @@ TOK Lexer::escapeStringConstant(Token *t, int wide)
     stringbuffer.reset();
     while (1)
     {
+        const utf8_t *q = skipPlain(p, end, '"', '\\');
+        stringbuffer.write(p, q - p);
+        p = q;
+
         c = *p++;
         switch (c)
         {
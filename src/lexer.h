@@ -21,6 +21,7 @@
 #include "tokens.h"
 
 struct StringTable;
+struct TokenCache;
 class Identifier;
 
 class Lexer
@@ -39,6 +40,7 @@ public:
     int anyToken;               // !=0 means seen at least one token
     int commentToken;           // !=0 means comments are TOKcomment's
     bool errors;                // errors occurred during lexing or parsing
+    TokenCache *tokcache;       // if !NULL, tokens come from or go to the cache
 
     Lexer(const char *filename,
         const utf8_t *base, size_t begoffset, size_t endoffset,
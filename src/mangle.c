@@ -132,6 +132,16 @@ void MODtoDecoBuffer(OutBuffer *buf, MOD mod)
     }
 }
 
+/*********************************
+ * Length of the mangling of mod by MODtoDecoBuffer().
+ */
+static size_t MODdecoLength(MOD mod)
+{
+    return ((mod & MODshared) ? 1 : 0) +
+           ((mod & MODwild) ? 2 : 0) +
+           ((mod & (MODconst | MODimmutable)) ? 1 : 0);
+}
+
 class Mangler : public Visitor
 {
 public:
@@ -151,6 +161,18 @@ public:
 
     void visitWithMask(Type *t, unsigned char modMask)
     {
+        if (t->deco)
+        {
+            /* Already merged, so its deco is what it mangles to under a
+             * mask of 0. Reuse it rather than mangling t all over again,
+             * less the mangling of t->mod if the mask leaves that out.
+             */
+            const char *deco = t->deco;
+            if (modMask == t->mod)
+                deco += MODdecoLength(t->mod);
+            buf->writestring(deco);
+            return;
+        }
         if (modMask != t->mod)
         {
             MODtoDecoBuffer(buf, t->mod);
@@ -18,11 +18,13 @@
 
 #if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
 #include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #endif
 
 #include "rmem.h"
 #include "root.h"
-#include "async.h"
 #include "target.h"
 
 #include "mars.h"
@@ -38,6 +40,7 @@
 #include "declaration.h"
 #include "hdrgen.h"
 #include "doc.h"
+#include "timetrace.h"
 
 bool response_expand(size_t *pargc, const char ***pargv);
 
@@ -46,6 +49,7 @@ void browse(const char *url);
 void getenv_setargv(const char *envvar, size_t *pargc, const char** *pargv);
 
 void printCtfePerformanceStats();
+void printTemplateStats();
 
 static const char* parse_arch_arg(size_t argc, const char** argv, const char* arch);
 static const char* parse_conf_arg(size_t argc, const char** argv);
@@ -115,6 +119,7 @@ void ensurePathToNameExists(Loc loc, const char *name)
 
 extern void backend_init();
 extern void backend_term();
+extern void flowstats_print();
 
 static void logo()
 {
@@ -147,6 +152,7 @@ Usage:\n\
   -conf=path     use config file at path\n\
   -cov           do code coverage analysis\n\
   -cov=nnn       require at least nnn%% code coverage\n\
+  -ctfe=bytecode run integer-only CTFE functions as bytecode\n\
   -D             generate documentation\n\
   -Dddocdir      write documentation file to docdir directory\n\
   -Dffilename    write documentation file to filename\n\
@@ -161,6 +167,9 @@ Usage:\n\
   -deps          print module dependencies (imports/file/version/debug/lib)\n\
   -deps=filename write module dependencies to filename (only imports)\n%s\
   -dip25         implement http://wiki.dlang.org/DIP25 (experimental)\n\
+  -ftime-trace   write time spent in each phase as a Chrome trace\n\
+  -ftime-trace-file=filename   write the trace to filename\n\
+  -ftime-trace-granularity=us  leave out spans shorter than us microseconds\n\
   -g             add symbolic debug info\n\
   -gc            add symbolic debug info, optimize for non D debuggers\n\
   -gs            always emit stack frame\n\
@@ -172,11 +181,15 @@ Usage:\n\
   -Ipath         where to look for imports\n\
   -ignore        ignore unsupported pragmas\n\
   -inline        do function inlining\n\
+  -j[=N]         analyze and generate object files with N jobs\n\
+                 in parallel (default: one per CPU)\n\
   -Jpath         where to look for string imports\n\
   -Llinkerflag   pass linkerflag to link\n\
   -lib           generate library rather than object files\n\
   -m32           generate 32 bit code\n\
   -m64           generate 64 bit code\n\
+  -mcpu=[baseline|skylake|zen]   leave optimized 64 bit code in the order it\n\
+                 is generated, or schedule it for Skylake or Zen\n\
   -main          add default main() (e.g. for unittesting)\n\
   -man           open web browser on manual page\n\
   -map           generate linker .map file\n\
@@ -188,18 +201,24 @@ Usage:\n\
   -offilename    name output file to filename\n\
   -op            preserve source path for output files\n\
   -profile       profile runtime performance of generated code\n\
+  -profile=ctfe  same as -vctfe\n\
   -property      enforce property syntax\n\
+  -regalloc=[weight|color]   put variables in registers one per code\n\
+                 generation pass, or colour them all in one pass\n\
   -release       compile release version\n\
   -run srcfile args...   run resulting program, passing args\n\
   -shared        generate shared library (DLL)\n\
+  -tokcache=dir  cache tokens of source files in directory dir\n\
   -transition=id show additional info about language change identified by 'id'\n\
   -transition=?  list all language changes\n\
   -unittest      compile in unit tests\n\
   -v             verbose\n\
   -vcolumns      print character (column) numbers in diagnostics\n\
+  -vctfe         list cost of functions evaluated at compile time\n\
   --version      print compiler version and exit\n\
   -version=level compile in version code >= level\n\
   -version=ident compile in version code identified by ident\n\
+  -vtemplates    list statistics on template instantiations\n\
   -vtls          list all variables going into thread local storage\n\
   -vgc           list all gc allocations including hidden ones\n\
   -verrors=num   limit the number of error messages (0 means unlimited)\n\
@@ -261,6 +280,403 @@ void genCmain(Scope *sc)
     rootHasMain = sc->module;
 }
 
+/**************************************
+ * Generate the object file for root module m.
+ */
+
+static void genModuleObjFile(Module *m, Library *library)
+{
+    if (global.params.verbose)
+        fprintf(global.stdmsg, "code      %s\n", m->toChars());
+    TimeTraceScope trace("codegen", m);
+
+    obj_start(m->srcfile->toChars());
+    genObjFile(m, global.params.multiobj);
+    if (entrypoint && m == rootHasMain)
+        genObjFile(entrypoint, global.params.multiobj);
+    for (size_t j = 0; j < Module::amodules.dim; j++)
+    {
+        Module *mx = Module::amodules[j];
+        if (mx != m && mx->importedFrom == m && (mx->marray || mx->massert || mx->munittest))
+            genhelpers(mx, true);
+    }
+    obj_end(library, m->objfile);
+    obj_write_deferred(library);
+
+    if (global.errors && !global.params.lib)
+        m->deleteObjFile();
+}
+
+#if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
+/**************************************
+ * Generate one object file per root module using up to `jobs` processes.
+ * The backend keeps all of its state in globals, so instead of threads each
+ * worker is a fork() of the compiler taken after semantic analysis, which
+ * gives it a private copy of the backend. Modules are handed out through a
+ * counter in shared memory, so a worker that finishes early keeps pulling
+ * modules until none are left. The calling process is one of the workers.
+ * Returns:
+ *      true if any worker failed
+ */
+
+static bool genObjFilesParallel(Modules *modules, unsigned jobs)
+{
+    size_t *pnext = (size_t *)mmap(NULL, sizeof(size_t), PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_ANON, -1, 0);
+    if (pnext == (size_t *)MAP_FAILED)
+    {
+        for (size_t i = 0; i < modules->dim; i++)
+            genModuleObjFile((*modules)[i], NULL);
+        return false;
+    }
+    *pnext = 0;
+
+    if (jobs > modules->dim)
+        jobs = (unsigned)modules->dim;
+
+    // Don't let buffered output be duplicated into the children
+    fflush(stdout);
+    fflush(stderr);
+
+    Array<pid_t> workers;
+    bool child = false;
+    for (unsigned n = 1; n < jobs; n++)
+    {
+        pid_t pid = fork();
+        if (pid == -1)
+            break;              // carry on with the workers we have
+        if (pid == 0)
+        {
+            child = true;
+            break;
+        }
+        workers.push(pid);
+    }
+
+    size_t i;
+    while ((i = __sync_fetch_and_add(pnext, 1)) < modules->dim)
+        genModuleObjFile((*modules)[i], NULL);
+
+    if (child)
+    {
+        fflush(stdout);
+        fflush(stderr);
+        _exit(global.errors ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    bool failed = false;
+    for (size_t j = 0; j < workers.dim; j++)
+    {
+        int status;
+        if (waitpid(workers[j], &status, 0) == -1 ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+            failed = true;
+    }
+    munmap(pnext, sizeof(size_t));
+    return failed;
+}
+
+/**************************************
+ * The groups of modules that import each other, directly or through other
+ * modules, found with Tarjan's algorithm in the imports seen by importAll().
+ */
+
+struct ImportCycles
+{
+    struct Node
+    {
+        size_t index;           // order visited in
+        size_t lowlink;         // lowest index reachable from here
+        size_t group;           // which group, once its root is done
+        bool onstack;
+    };
+
+    FlatAA nodes;               // Node * by Module *
+    Modules stack;
+    size_t nvisited;
+    size_t ngroups;
+
+    ImportCycles() : nvisited(0), ngroups(0) { }
+
+    size_t group(Module *m)
+    {
+        Node *n = (Node *)nodes.getRvalue(m);
+        if (!n)
+            n = visit(m);
+        return n->group;
+    }
+
+    Node *visit(Module *m)
+    {
+        Node *n = (Node *)mem.malloc(sizeof(Node));
+        n->index = nvisited++;
+        n->lowlink = n->index;
+        n->group = 0;
+        n->onstack = true;
+        *nodes.get(m) = n;
+        stack.push(m);
+
+        for (size_t i = 0; i < m->importedAll.dim; i++)
+        {
+            Module *mi = m->importedAll[i];
+            Node *ni = (Node *)nodes.getRvalue(mi);
+            if (!ni)
+            {
+                ni = visit(mi);
+                if (ni->lowlink < n->lowlink)
+                    n->lowlink = ni->lowlink;
+            }
+            else if (ni->onstack && ni->index < n->lowlink)
+                n->lowlink = ni->index;
+        }
+
+        if (n->lowlink == n->index)
+        {
+            // n is the first of its group to be visited, the rest are above it
+            Module *mi;
+            do
+            {
+                mi = stack.pop();
+                Node *ni = (Node *)nodes.getRvalue(mi);
+                ni->onstack = false;
+                ni->group = ngroups;
+            } while (mi != m);
+            ngroups++;
+        }
+        return n;
+    }
+};
+
+static Array<pid_t> semanticWorkers;
+static bool isSemanticWorker;   // this process is one of the semanticWorkers
+static Modules semanticRoots;   // the root modules of all the workers
+
+/* A worker exits with this when it had errors, but they were all in
+ * modules another worker reports the errors of.
+ */
+#define EXIT_QUIETFAILURE 2
+
+/**************************************
+ * Exit status of this process as a worker that had errors.
+ */
+
+static int semanticWorkerFailure()
+{
+    return global.errors + global.warnings > global.quietErrors ? EXIT_FAILURE : EXIT_QUIETFAILURE;
+}
+
+static void exitSemanticWorker()
+{
+    // fatal() was called
+    if (global.errors || global.warnings)
+    {
+        fflush(stdout);
+        fflush(stderr);
+        _exit(semanticWorkerFailure());
+    }
+}
+
+/**************************************
+ * Wait for the workers, and if this process or any of them failed,
+ * remove the object files they wrote, so there are none left from a
+ * failed compile as with -j=1.
+ * Returns:
+ *      true if any worker failed
+ */
+
+static bool waitSemanticWorkers()
+{
+    bool failed = false;
+    bool reported = global.errors + global.warnings > global.quietErrors;
+    for (size_t i = 0; i < semanticWorkers.dim; i++)
+    {
+        int status;
+        if (waitpid(semanticWorkers[i], &status, 0) == -1 || !WIFEXITED(status))
+            failed = reported = true;
+        else if (WEXITSTATUS(status) == EXIT_QUIETFAILURE)
+            failed = true;
+        else if (WEXITSTATUS(status) != EXIT_SUCCESS)
+            failed = reported = true;
+    }
+    semanticWorkers.setDim(0);
+
+    if (failed || global.errors || global.warnings)
+    {
+        /* The errors were in modules whose worker didn't run into
+         * them, so nobody printed them.
+         */
+        if (!reported)
+        {
+            global.quiet = false;
+            global.errorLimit = 0;      // this may be running from atexit()
+            error(Loc(), "errors in modules analyzed by other jobs were not shown, compile with -j=1 to see them");
+        }
+        for (size_t i = 0; i < semanticRoots.dim; i++)
+            semanticRoots[i]->deleteObjFile();
+    }
+    semanticRoots.setDim(0);
+    return failed;
+}
+
+static void atexitSemanticWorkers()
+{
+    // fatal() was called before joinSemanticWorkers()
+    waitSemanticWorkers();
+}
+
+/**************************************
+ * Split the root modules between up to `jobs` processes, each of which
+ * then runs semantic analysis on and generates the object files of its
+ * share, like genObjFilesParallel() but starting from after importAll().
+ * Modules that import each other in a circle stay together, so no two
+ * workers analyze the same cycle, and the groups are spread over the
+ * workers by number of lines. Each worker treats the root modules it was
+ * not given as imports, as a compile of just its own modules would.
+ * Errors are printed by the worker given the root module they are in,
+ * or that first imported the module they are in, and counted but not
+ * printed by the others.
+ * The calling process is one of the workers.
+ * Returns:
+ *      false if there is nothing to split, otherwise true with the root
+ *      modules this process is to compile in *modules
+ */
+
+static bool forkSemanticWorkers(Modules *modules, unsigned jobs)
+{
+    ImportCycles cycles;
+    Array<size_t> groups;       // group of each root module
+    groups.setDim(modules->dim);
+    for (size_t i = 0; i < modules->dim; i++)
+        groups[i] = cycles.group((*modules)[i]);
+
+    Array<size_t> weight;       // lines of root modules in each group
+    weight.setDim(cycles.ngroups);
+    weight.zero();
+    size_t nused = 0;
+    for (size_t i = 0; i < modules->dim; i++)
+    {
+        if (!weight[groups[i]])
+            nused++;
+        weight[groups[i]] += (*modules)[i]->numlines + 1;
+    }
+    if (jobs > nused)
+        jobs = (unsigned)nused;
+    if (jobs < 2)
+        return false;
+
+    /* Give each group, heaviest first, to the worker with the fewest
+     * lines so far.
+     */
+    Array<size_t> worker;       // worker of each group
+    worker.setDim(cycles.ngroups);
+    Array<size_t> load;
+    load.setDim(jobs);
+    load.zero();
+    for (size_t n = 0; n < nused; n++)
+    {
+        size_t g = 0;
+        for (size_t j = 1; j < cycles.ngroups; j++)
+        {
+            if (weight[j] > weight[g])
+                g = j;
+        }
+        size_t w = 0;
+        for (size_t j = 1; j < jobs; j++)
+        {
+            if (load[j] < load[w])
+                w = j;
+        }
+        worker[g] = w;
+        load[w] += weight[g];
+        weight[g] = 0;
+    }
+
+    // Don't let buffered output be duplicated into the children
+    fflush(stdout);
+    fflush(stderr);
+
+    size_t self = 0;
+    for (unsigned n = 1; n < jobs; n++)
+    {
+        pid_t pid = fork();
+        if (pid == -1)
+            break;              // the calling process takes the rest
+        if (pid == 0)
+        {
+            self = n;
+            isSemanticWorker = true;
+            semanticWorkers.setDim(0);
+            break;
+        }
+        semanticWorkers.push(pid);
+    }
+    if (self == 0)
+    {
+        // Don't leave workers writing object files behind if fatal() exits
+        atexit(&atexitSemanticWorkers);
+    }
+    else
+        atexit(&exitSemanticWorker);
+    size_t nworkers = semanticWorkers.dim + 1;
+
+    Modules all;
+    all.append(modules);
+    modules->setDim(0);
+    for (size_t i = 0; i < all.dim; i++)
+    {
+        size_t w = worker[groups[i]];
+        if (self == 0 && w >= nworkers)
+            w = 0;              // its worker didn't start
+        if (w == self)
+            modules->push(all[i]);
+        all[i]->quiet = w != self;
+    }
+    semanticRoots.append(&all);
+
+    // The modules loaded so far are reported on with the root that loaded them
+    for (size_t i = 0; i < Module::amodules.dim; i++)
+    {
+        Module *m = Module::amodules[i];
+        if (m->importedFrom && !m->isRoot())
+            m->quiet = m->importedFrom->quiet;
+    }
+
+    /* The root modules this process isn't compiling are imports now,
+     * and so are the modules first imported by them.
+     */
+    for (size_t i = 0; i < all.dim; i++)
+        all[i]->importedFrom = NULL;
+    for (size_t i = 0; i < modules->dim; i++)
+        (*modules)[i]->importedFrom = (*modules)[i];
+    Module::rootModule = (*modules)[0];
+    for (size_t i = 0; i < Module::amodules.dim; i++)
+    {
+        Module *m = Module::amodules[i];
+        if (!m->importedFrom || !m->importedFrom->isRoot())
+            m->importedFrom = Module::rootModule;
+    }
+    return true;
+}
+
+/**************************************
+ * Wait for the workers started by forkSemanticWorkers().
+ * The workers themselves exit here, with whether they had errors.
+ * Returns:
+ *      true if any worker failed
+ */
+
+static bool joinSemanticWorkers()
+{
+    if (isSemanticWorker)
+    {
+        fflush(stdout);
+        fflush(stderr);
+        _exit(global.errors ? semanticWorkerFailure() : EXIT_SUCCESS);
+    }
+    return waitSemanticWorkers();
+}
+#endif
+
 int tryMain(size_t argc, const char *argv[])
 {
     Strings files;
@@ -273,6 +689,7 @@ int tryMain(size_t argc, const char *argv[])
     bool setdefaultlib = false;
 #endif
     global.init();
+    timeTraceBegin();
 
 #ifdef DEBUG
     printf("DMD %s DEBUG\n", global.version);
@@ -311,6 +728,7 @@ int tryMain(size_t argc, const char *argv[])
     global.params.useInline = false;
     global.params.obj = true;
     global.params.useDeprecated = 2;
+    global.params.timeTraceGranularity = 500;
 
     global.params.linkswitches = new Strings();
     global.params.libfiles = new Strings();
@@ -476,6 +894,14 @@ int tryMain(size_t argc, const char *argv[])
             }
             else if (strcmp(p + 1, "shared") == 0)
                 global.params.dll = true;
+            else if (strcmp(p + 1, "ctfe=bytecode") == 0)
+                global.params.ctfeBytecode = true;
+            else if (memcmp(p + 1, "tokcache=", 9) == 0)
+            {
+                global.params.tokcachedir = p + 1 + 9;
+                if (!global.params.tokcachedir[0])
+                    goto Lnoarg;
+            }
             else if (strcmp(p + 1, "dylib") == 0)
             {
 #if TARGET_OSX
@@ -519,6 +945,19 @@ int tryMain(size_t argc, const char *argv[])
                 global.params.is64bit = true;
                 global.params.mscoff = true;
             }
+            else if (memcmp(p + 1, "mcpu", 4) == 0)
+            {
+                // Parse:
+                //      -mcpu=[baseline|skylake|zen]
+                if (strcmp(p + 5, "=baseline") == 0)
+                    global.params.cpu = CPUbaseline;
+                else if (strcmp(p + 5, "=skylake") == 0)
+                    global.params.cpu = CPUskylake;
+                else if (strcmp(p + 5, "=zen") == 0)
+                    global.params.cpu = CPUzen;
+                else
+                    goto Lerror;
+            }
             else if (strcmp(p + 1, "m32mscoff") == 0)
             {
             #if TARGET_WINDOS
@@ -534,6 +973,10 @@ int tryMain(size_t argc, const char *argv[])
                 global.params.verbose = true;
             else if (strcmp(p + 1, "vtls") == 0)
                 global.params.vtls = true;
+            else if (strcmp(p + 1, "vtemplates") == 0)
+                global.params.vtemplates = true;
+            else if (strcmp(p + 1, "vctfe") == 0 || strcmp(p + 1, "profile=ctfe") == 0)
+                global.params.vctfe = true;
             else if (strcmp(p + 1, "vcolumns") == 0)
                 global.params.showColumns = true;
             else if (strcmp(p + 1, "vgc") == 0)
@@ -720,6 +1163,57 @@ Language changes listed by -transition=id:\n\
                 global.params.useInline = true;
             else if (strcmp(p + 1, "dip25") == 0)
                 global.params.useDIP25 = true;
+            else if (strcmp(p + 1, "ftime-trace") == 0)
+                global.params.timeTrace = true;
+            else if (memcmp(p + 1, "ftime-trace-file=", 17) == 0)
+            {
+                global.params.timeTrace = true;
+                global.params.timeTraceFile = p + 1 + 17;
+                if (!global.params.timeTraceFile[0])
+                    goto Lnoarg;
+            }
+            else if (memcmp(p + 1, "ftime-trace-granularity=", 24) == 0)
+            {
+                global.params.timeTrace = true;
+                if (!isdigit((utf8_t)p[25]))
+                    goto Lerror;
+                errno = 0;
+                long num = strtol(p + 25, (char **)&p, 10);
+                if (*p || errno || num < 0 || num > 100000000)
+                    goto Lerror;
+                global.params.timeTraceGranularity = (unsigned)num;
+            }
+            else if (p[1] == 'j')
+            {
+                // Parse:
+                //      -j
+                //      -j=number
+                if (p[2] == '=')
+                {
+                    if (isdigit((utf8_t)p[3]))
+                    {   long num;
+
+                        errno = 0;
+                        num = strtol(p + 3, (char **)&p, 10);
+                        if (*p || errno || num < 1 || num > 1024)
+                            goto Lerror;
+                        global.params.jobs = (unsigned)num;
+                    }
+                    else
+                        goto Lerror;
+                }
+                else if (p[2])
+                    goto Lerror;
+                else
+                {
+#if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
+                    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+                    global.params.jobs = ncpus > 0 ? (unsigned)ncpus : 1;
+#else
+                    global.params.jobs = 1;
+#endif
+                }
+            }
             else if (strcmp(p + 1, "lib") == 0)
                 global.params.lib = true;
             else if (strcmp(p + 1, "nofloat") == 0)
@@ -764,6 +1258,17 @@ Language changes listed by -transition=id:\n\
                 else
                     goto Lerror;
             }
+            else if (memcmp(p + 1, "regalloc", 8) == 0)
+            {
+                // Parse:
+                //      -regalloc=[weight|color]
+                if (strcmp(p + 9, "=weight") == 0)
+                    global.params.regColor = false;
+                else if (strcmp(p + 9, "=color") == 0)
+                    global.params.regColor = true;
+                else
+                    goto Lerror;
+            }
             else if (strcmp(p + 1, "unittest") == 0)
                 global.params.useUnitTests = true;
             else if (p[1] == 'I')
@@ -1312,24 +1817,16 @@ Language changes listed by -transition=id:\n\
         }
     }
 
-#define ASYNCREAD 1
-#if ASYNCREAD
-    // Multi threaded
-    AsyncRead *aw = AsyncRead::create(modules.dim);
-    for (size_t i = 0; i < modules.dim; i++)
-    {
-        Module *m = modules[i];
-        aw->addFile(m->srcfile);
-    }
-    aw->start();
-#else
-    // Single threaded
+    /* Map all the files in before parsing any of them. Mapping a file
+     * starts the system reading it in, so the files parsed later are
+     * read while the earlier ones are parsed. A file that can't be read
+     * is tried again, and reported, when its turn comes to be parsed.
+     */
     for (size_t i = 0; i < modules.dim; i++)
     {
         Module *m = modules[i];
-        m->read(Loc());
+        m->srcfile->mmread();
     }
-#endif
 
     // Parse files
     bool anydocfiles = false;
@@ -1344,13 +1841,14 @@ Language changes listed by -transition=id:\n\
         m->importedFrom = m;    // m->isRoot() == true
         if (!global.params.oneobj || modi == 0 || m->isDocFile)
             m->deleteObjFile();
-#if ASYNCREAD
-        if (aw->read(filei))
         {
-            error(Loc(), "cannot read file %s", m->srcfile->name->toChars());
-            fatal();
+            TimeTraceScope trace("read", m->srcfile->toChars());
+            if (m->srcfile->mmread())
+            {
+                error(Loc(), "cannot read file %s", m->srcfile->name->toChars());
+                fatal();
+            }
         }
-#endif
         m->parse();
         if (m->isDocFile)
         {
@@ -1375,9 +1873,6 @@ Language changes listed by -transition=id:\n\
                 global.params.link = false;
         }
     }
-#if ASYNCREAD
-    AsyncRead::dispose(aw);
-#endif
 
     if (anydocfiles && modules.dim &&
         (global.params.oneobj || global.params.objname))
@@ -1411,11 +1906,26 @@ Language changes listed by -transition=id:\n\
        Module *m = modules[i];
        if (global.params.verbose)
            fprintf(global.stdmsg, "importall %s\n", m->toChars());
+       TimeTraceScope trace("importAll", m);
        m->importAll(NULL);
     }
     if (global.errors)
         fatal();
 
+#if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
+    if (global.params.jobs > 1 && modules.dim > 1 &&
+        global.params.obj && !global.params.oneobj && !global.params.lib &&
+        !global.params.multiobj && !global.params.run &&
+        !global.params.timeTrace &&     // the workers' spans would be lost
+        // these want every module in the one process
+        !global.params.doDocComments && !global.params.doJsonGeneration &&
+        !global.params.moduleDeps && !global.params.vtemplates && !global.params.vctfe)
+    {
+        if (forkSemanticWorkers(&modules, global.params.jobs))
+            global.params.jobs = 1;     // each worker generates its own code
+    }
+#endif
+
     backend_init();
 
     // Do semantic analysis
@@ -1424,11 +1934,14 @@ Language changes listed by -transition=id:\n\
         Module *m = modules[i];
         if (global.params.verbose)
             fprintf(global.stdmsg, "semantic  %s\n", m->toChars());
+        TimeTraceScope trace("semantic1", m);
         m->semantic();
     }
     if (global.errors)
         fatal();
 
+    // Whatever is still waiting gets a last try, in case it waited on the wrong thing
+    Module::wakeAllDeferredSemantic();
     Module::dprogress = 1;
     Module::runDeferredSemantic();
     if (Module::deferred.dim)
@@ -1436,8 +1949,11 @@ Language changes listed by -transition=id:\n\
         for (size_t i = 0; i < Module::deferred.dim; i++)
         {
             Dsymbol *sd = Module::deferred[i];
+            Module *m = sd->getModule();
+            global.quiet = m && m->quiet;
             sd->error("unable to resolve forward reference in definition");
         }
+        global.quiet = false;
         fatal();
     }
 
@@ -1447,6 +1963,7 @@ Language changes listed by -transition=id:\n\
         Module *m = modules[i];
         if (global.params.verbose)
             fprintf(global.stdmsg, "semantic2 %s\n", m->toChars());
+        TimeTraceScope trace("semantic2", m);
         m->semantic2();
     }
     if (global.errors)
@@ -1458,9 +1975,13 @@ Language changes listed by -transition=id:\n\
         Module *m = modules[i];
         if (global.params.verbose)
             fprintf(global.stdmsg, "semantic3 %s\n", m->toChars());
+        TimeTraceScope trace("semantic3", m);
         m->semantic3();
     }
-    Module::runDeferredSemantic3();
+    {
+        TimeTraceScope trace("deferred semantic3");
+        Module::runDeferredSemantic3();
+    }
     if (global.errors)
         fatal();
 
@@ -1472,6 +1993,7 @@ Language changes listed by -transition=id:\n\
             Module *m = modules[i];
             if (global.params.verbose)
                 fprintf(global.stdmsg, "inline scan %s\n", m->toChars());
+            TimeTraceScope trace("inlineScan", m);
             inlineScan(m);
         }
     }
@@ -1489,6 +2011,7 @@ Language changes listed by -transition=id:\n\
         {
             File deps(global.params.moduleDepsFile);
             deps.setbuffer((void*)ob->data, ob->offset);
+            deps.ref = 1;
             writeFile(Loc(), &deps);
         }
         else
@@ -1496,6 +2019,12 @@ Language changes listed by -transition=id:\n\
     }
 
     printCtfePerformanceStats();
+    printTemplateStats();
+    if (global.params.verbose)
+    {
+        Module::printSearchStats();
+        Module::printDeferredStats();
+    }
 
     Library *library = NULL;
     if (global.params.lib)
@@ -1580,6 +2109,7 @@ Language changes listed by -transition=id:\n\
             Module *m = modules[i];
             if (global.params.verbose)
                 fprintf(global.stdmsg, "code      %s\n", m->toChars());
+            TimeTraceScope trace("codegen", m);
             genObjFile(m, false);
             if (entrypoint && m == rootHasMain)
                 genObjFile(entrypoint, false);
@@ -1595,35 +2125,31 @@ Language changes listed by -transition=id:\n\
             obj_end(library, modules[0]->objfile);
         }
     }
+#if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
+    else if (global.params.jobs > 1 && !library && !global.params.multiobj && modules.dim > 1 &&
+             !global.params.timeTrace)  // the workers' spans would be lost
+    {
+        if (genObjFilesParallel(&modules, global.params.jobs))
+            global.increaseErrorCount();
+    }
+#endif
     else
     {
         for (size_t i = 0; i < modules.dim; i++)
-        {
-            Module *m = modules[i];
-            if (global.params.verbose)
-                fprintf(global.stdmsg, "code      %s\n", m->toChars());
-
-            obj_start(m->srcfile->toChars());
-            genObjFile(m, global.params.multiobj);
-            if (entrypoint && m == rootHasMain)
-                genObjFile(entrypoint, global.params.multiobj);
-            for (size_t j = 0; j < Module::amodules.dim; j++)
-            {
-                Module *mx = Module::amodules[j];
-                if (mx != m && mx->importedFrom == m && (mx->marray || mx->massert || mx->munittest))
-                    genhelpers(mx, true);
-            }
-            obj_end(library, m->objfile);
-            obj_write_deferred(library);
-
-            if (global.errors && !global.params.lib)
-                m->deleteObjFile();
-        }
+            genModuleObjFile(modules[i], library);
     }
 
     if (global.params.lib && !global.errors)
         library->write();
 
+    if (global.params.verbose)
+        flowstats_print();
+
+#if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
+    if (joinSemanticWorkers())
+        global.increaseErrorCount();
+#endif
+
     backend_term();
     if (global.errors)
         fatal();
@@ -1637,7 +2163,10 @@ Language changes listed by -transition=id:\n\
     else
     {
         if (global.params.link)
+        {
+            TimeTraceScope trace("link");
             status = runLINK();
+        }
 
         if (global.params.run)
         {
@@ -1658,6 +2187,23 @@ Language changes listed by -transition=id:\n\
         }
     }
 
+    if (global.params.timeTrace)
+    {
+        const char *name = global.params.timeTraceFile;
+        if (!name)
+        {
+            // Put it next to the first object file
+            name = modules.dim ? modules[0]->objfile->toChars() : "dmd";
+            name = FileName::forceExt(name, "time-trace");
+        }
+        timeTraceWrite(name);
+    }
+
+    mem.printStats();
+    Identifier::stringtable.printStats("identifiers");
+    Type::stringtable.printStats("types");
+    Type::structtable.printStats("type structures");
+
     return status;
 }
 
@@ -23,6 +23,8 @@
 #include "dsymbol.h"
 #include "expression.h"
 #include "lexer.h"
+#include "tokcache.h"
+#include "timetrace.h"
 #include "attrib.h"
 #include "target.h"
 
@@ -35,6 +37,16 @@ Modules Module::amodules;
 Dsymbols Module::deferred; // deferred Dsymbol's needing semantic() run on them
 Dsymbols Module::deferred3;
 unsigned Module::dprogress;
+FlatAA Module::deferredState;
+FlatAA Module::deferredWaiters;
+size_t Module::deferredWaiting;
+unsigned Module::deferredPasses;
+unsigned Module::deferredRetries;
+
+unsigned Module::searchCacheGeneration;
+unsigned Module::searchCacheHits;
+unsigned Module::searchCacheMisses;
+bool Module::searchCutShort;
 
 const char *lookForSourceFile(const char *filename);
 
@@ -60,6 +72,7 @@ Module::Module(const char *filename, Identifier *ident, int doDocComment, int do
     selfimports = 0;
     rootimports = 0;
     insearch = 0;
+    searchCacheGen = 0;
     searchCacheIdent = NULL;
     searchCacheSymbol = NULL;
     searchCacheFlags = 0;
@@ -75,6 +88,7 @@ Module::Module(const char *filename, Identifier *ident, int doDocComment, int do
     stest = NULL;
     sfilename = NULL;
     importedFrom = NULL;
+    quiet = false;
     srcfile = NULL;
     docfile = NULL;
 
@@ -255,7 +269,8 @@ Module *Module::load(Loc loc, Identifiers *packages, Identifier *ident)
 bool Module::read(Loc loc)
 {
     //printf("Module::read('%s') file '%s'\n", toChars(), srcfile->toChars());
-    if (srcfile->read())
+    TimeTraceScope trace("read", srcfile->toChars());
+    if (srcfile->mmread())
     {
         if (!strcmp(srcfile->toChars(), "object.d"))
         {
@@ -329,6 +344,7 @@ void Module::parse()
 
     char *srcname = srcfile->name->toChars();
     //printf("Module::parse(srcname = '%s')\n", srcname);
+    TimeTraceScope trace("parse", srcname);
 
     isPackageFile = (strcmp(srcfile->name->name(), "package.d") == 0);
 
@@ -509,18 +525,20 @@ void Module::parse()
     }
     {
         Parser p(this, buf, buflen, docfile != NULL);
+        TokenCache *tc = NULL;
+        if (global.params.tokcachedir && !docfile)
+            tc = TokenCache::attach(global.params.tokcachedir, &p);
         p.nextToken();
         members = p.parseModule();
         md = p.md;
         numlines = p.scanloc.linnum;
+        if (tc)
+            tc->detach(&p);
         if (p.errors)
             ++global.errors;
     }
 
-    if (srcfile->ref == 0)
-        ::free(srcfile->buffer);
-    srcfile->buffer = NULL;
-    srcfile->len = 0;
+    srcfile->freeBuffer();
 
     /* The symbol table into which the module is to be inserted.
      */
@@ -669,7 +687,7 @@ void Module::importAll(Scope *prevsc)
     if (!symtab)
     {
         // Add all symbols into module's symbol table
-        symtab = new DsymbolTable();
+        symtab = new DsymbolTable(members->dim);
         for (size_t i = 0; i < members->dim; i++)
         {
             Dsymbol *s = (*members)[i];
@@ -707,6 +725,8 @@ void Module::semantic()
 
     //printf("+Module::semantic(this = %p, '%s'): parent = %p\n", this, toChars(), parent);
     semanticRun = PASSsemantic;
+    bool oldquiet = global.quiet;
+    global.quiet = quiet;
 
     // Note that modules get their own scope, from scratch.
     // This is so regardless of where in the syntax a module
@@ -739,6 +759,7 @@ void Module::semantic()
         sc = sc->pop();
         sc->pop();              // 2 pops because Scope::createGlobal() created 2
     }
+    global.quiet = oldquiet;
     semanticRun = PASSsemanticdone;
     //printf("-Module::semantic(this = %p, '%s'): parent = %p\n", this, toChars(), parent);
 }
@@ -749,6 +770,8 @@ void Module::semantic2()
     if (semanticRun != PASSsemanticdone)       // semantic() not completed yet - could be recursive call
         return;
     semanticRun = PASSsemantic2;
+    bool oldquiet = global.quiet;
+    global.quiet = quiet;
 
     // Note that modules get their own scope, from scratch.
     // This is so regardless of where in the syntax a module
@@ -770,6 +793,7 @@ void Module::semantic2()
 
     sc = sc->pop();
     sc->pop();
+    global.quiet = oldquiet;
     semanticRun = PASSsemantic2done;
     //printf("-Module::semantic2('%s'): parent = %p\n", toChars(), parent);
 }
@@ -780,6 +804,8 @@ void Module::semantic3()
     if (semanticRun != PASSsemantic2done)
         return;
     semanticRun = PASSsemantic3;
+    bool oldquiet = global.quiet;
+    global.quiet = quiet;
 
     // Note that modules get their own scope, from scratch.
     // This is so regardless of where in the syntax a module
@@ -802,6 +828,7 @@ void Module::semantic3()
 
     sc = sc->pop();
     sc->pop();
+    global.quiet = oldquiet;
     semanticRun = PASSsemantic3done;
 }
 
@@ -825,65 +852,201 @@ Dsymbol *Module::search(Loc loc, Identifier *ident, int flags)
 
     //printf("%s Module::search('%s', flags = %d) insearch = %d\n", toChars(), ident->toChars(), flags, insearch);
     if (insearch)
+    {
+        searchCutShort = true;
         return NULL;
+    }
+
+    if (searchCacheGen != searchCacheGeneration)
+    {
+        searchCache.reset();
+        searchCacheNotFound.reset();
+        searchCacheIdent = NULL;
+        searchCacheGen = searchCacheGeneration;
+    }
+
+    /* Identifiers are further apart in memory than the flags go up to,
+     * so ident + flags is a key for the pair of them.
+     */
+    void *key = (char *)ident + flags;
+    if (Dsymbol *s = (Dsymbol *)searchCache.getRvalue(key))
+    {
+        searchCacheHits++;
+        return s;
+    }
+    if (searchCacheNotFound.getRvalue(key))
+    {
+        searchCacheHits++;
+        return NULL;
+    }
     if (searchCacheIdent == ident && searchCacheFlags == flags)
     {
         //printf("%s Module::search('%s', flags = %d) insearch = %d searchCacheSymbol = %s\n",
         //        toChars(), ident->toChars(), flags, insearch, searchCacheSymbol ? searchCacheSymbol->toChars() : "null");
+        searchCacheHits++;
+        searchCutShort = true;
         return searchCacheSymbol;
     }
+    searchCacheMisses++;
 
     unsigned int errors = global.errors;
+    bool cutShort = searchCutShort;
+    searchCutShort = false;
 
     insearch = 1;
     Dsymbol *s = ScopeDsymbol::search(loc, ident, flags);
     insearch = 0;
 
-    if (errors == global.errors)
+    /* Bugzilla 10752: We can cache the result only when it does not cause
+     * access error so the side-effect should be reproduced in later search.
+     * Nor if symbols were added along the way.
+     */
+    if (errors == global.errors && searchCacheGen == searchCacheGeneration)
     {
-        // Bugzilla 10752: We can cache the result only when it does not cause
-        // access error so the side-effect should be reproduced in later search.
-        searchCacheIdent = ident;
-        searchCacheSymbol = s;
-        searchCacheFlags = flags;
+        if (!searchCutShort)
+        {
+            if (s)
+                *searchCache.get(key) = s;
+            else
+                *searchCacheNotFound.get(key) = ident;
+        }
+        else
+        {
+            /* A module imported in a circle was already being searched, so
+             * the result may be missing what that module would have found.
+             * Only keep it until the next such search, which is enough to
+             * stop searches of densely imported modules from going
+             * exponential (Bugzilla 13152).
+             */
+            searchCacheIdent = ident;
+            searchCacheSymbol = s;
+            searchCacheFlags = flags;
+        }
     }
+    searchCutShort |= cutShort;
     return s;
 }
 
 Dsymbol *Module::symtabInsert(Dsymbol *s)
 {
-    searchCacheIdent = NULL;       // symbol is inserted, so invalidate cache
+    clearCache();       // symbol is inserted, so invalidate caches
     return Package::symtabInsert(s);
 }
 
+/*******************************************
+ * Invalidate what every module's search() has cached, as a symbol or
+ * import has been added that it may now find.
+ */
+
 void Module::clearCache()
 {
-    for (size_t i = 0; i < amodules.dim; i++)
-    {
-        Module *m = amodules[i];
-        m->searchCacheIdent = NULL;
-    }
+    searchCacheGeneration++;
+}
+
+void Module::printSearchStats()
+{
+    fprintf(global.stdmsg, "search    %u lookups through imports, %u cached\n",
+        searchCacheHits + searchCacheMisses, searchCacheHits);
+}
+
+/* What the deferred list knows of a Dsymbol, in deferredState.
+ * Entries aren't removed from a FlatAA, so a Dsymbol no longer deferred
+ * is left as DEFERREDnone.
+ */
+enum DeferredState
+{
+    DEFERREDnone = 1,
+    DEFERREDqueued,             // to be tried again on the next pass
+    DEFERREDwaiting             // only to be tried again once woken
+};
+
+static DeferredState getDeferredState(Dsymbol *s)
+{
+    size_t state = (size_t)Module::deferredState.getRvalue(s);
+    return state ? (DeferredState)state : DEFERREDnone;
+}
+
+static void setDeferredState(Dsymbol *s, DeferredState state)
+{
+    *Module::deferredState.get(s) = (void *)(size_t)state;
 }
 
 /*******************************************
  * Can't run semantic on s now, try again later.
+ * If it is known what s is waiting on, s stays in the deferred list
+ * but is passed over until waitingOn wakes it, rather than being tried
+ * again on every pass.
  */
 
-void Module::addDeferredSemantic(Dsymbol *s)
+void Module::addDeferredSemantic(Dsymbol *s, Dsymbol *waitingOn)
 {
-    // Don't add it if it is already there
-    for (size_t i = 0; i < deferred.dim; i++)
-    {
-        Dsymbol *sd = deferred[i];
+    //printf("Module::addDeferredSemantic('%s')\n", s->toChars());
+    DeferredState state = getDeferredState(s);
+    if (waitingOn == s)
+        waitingOn = NULL;
 
-        if (sd == s)
-            return;
+    if (waitingOn && state != DEFERREDqueued)
+    {
+        if (state == DEFERREDnone)
+            deferred.push(s);
+        else
+            deferredWaiting--;  // counted again below
+        Dsymbols **pwaiters = (Dsymbols **)deferredWaiters.get(waitingOn);
+        if (!*pwaiters)
+            *pwaiters = new Dsymbols();
+        (*pwaiters)->push(s);
+        setDeferredState(s, DEFERREDwaiting);
+        deferredWaiting++;
+        return;
     }
 
-    //printf("Module::addDeferredSemantic('%s')\n", s->toChars());
-    deferred.push(s);
+    if (state == DEFERREDnone)
+        deferred.push(s);
+    else if (state == DEFERREDwaiting)
+        deferredWaiting--;
+    setDeferredState(s, DEFERREDqueued);
 }
 
+/*******************************************
+ * Semantic on s is done, so try again whatever was waiting on it.
+ */
+
+void Module::wakeDeferredSemantic(Dsymbol *s)
+{
+    if (!deferredWaiting)
+        return;
+    if (getDeferredState(s) == DEFERREDwaiting)
+    {
+        // Done without waiting after all, so let the next pass drop it
+        setDeferredState(s, DEFERREDqueued);
+        deferredWaiting--;
+    }
+    Dsymbols *waiters = (Dsymbols *)deferredWaiters.getRvalue(s);
+    if (!waiters)
+        return;
+    for (size_t i = 0; i < waiters->dim; i++)
+    {
+        Dsymbol *sw = (*waiters)[i];
+        if (getDeferredState(sw) == DEFERREDwaiting)
+        {
+            setDeferredState(sw, DEFERREDqueued);
+            deferredWaiting--;
+        }
+    }
+    waiters->setDim(0);
+}
+
+/*******************************************
+ * Try again everything that is waiting, whatever it waits on.
+ */
+
+void Module::wakeAllDeferredSemantic()
+{
+    for (size_t i = 0; i < deferred.dim; i++)
+        setDeferredState(deferred[i], DEFERREDqueued);
+    deferredWaiters.reset();
+    deferredWaiting = 0;
+}
 
 /******************************************
  * Run semantic() on deferred symbols.
@@ -905,40 +1068,48 @@ void Module::runDeferredSemantic()
     {
         dprogress = 0;
         len = deferred.dim;
-        if (!len)
-            break;
+        if (len == deferredWaiting)
+            break;              // all of it is waiting
+        TimeTraceScope trace("deferred semantic");
+        deferredPasses++;
 
-        Dsymbol **todo;
-        Dsymbol **todoalloc = NULL;
-        Dsymbol *tmp;
-        if (len == 1)
-        {
-            todo = &tmp;
-        }
-        else
-        {
-            todo = (Dsymbol **)malloc(len * sizeof(Dsymbol *));
-            assert(todo);
-            todoalloc = todo;
-        }
-        memcpy(todo, deferred.tdata(), len * sizeof(Dsymbol *));
+        Dsymbols todo;
+        todo.append(&deferred);
         deferred.setDim(0);
 
-        for (size_t i = 0; i < len; i++)
+        for (size_t i = 0; i < todo.dim; i++)
         {
             Dsymbol *s = todo[i];
 
+            if (getDeferredState(s) == DEFERREDwaiting)
+            {
+                // Keep its place; it may be woken before the next pass
+                deferred.push(s);
+                continue;
+            }
+            setDeferredState(s, DEFERREDnone);
+            deferredRetries++;
+            Module *m = s->getModule();
+            bool oldquiet = global.quiet;
+            global.quiet = m && m->quiet;
             s->semantic(NULL);
+            global.quiet = oldquiet;
             //printf("deferred: %s, parent = %s\n", s->toChars(), s->parent->toChars());
         }
         //printf("\tdeferred.dim = %d, len = %d, dprogress = %d\n", deferred.dim, len, dprogress);
-        if (todoalloc)
-            free(todoalloc);
     } while (deferred.dim < len || dprogress);  // while making progress
+    if (!deferred.dim)
+        deferredState.reset();
     nested--;
     //printf("-Module::runDeferredSemantic(), len = %d\n", deferred.dim);
 }
 
+void Module::printDeferredStats()
+{
+    fprintf(global.stdmsg, "deferred  %u passes over deferred symbols, %u retried\n",
+        deferredPasses, deferredRetries);
+}
+
 void Module::addDeferredSemantic3(Dsymbol *s)
 {
     // Don't add it if it is already there
@@ -1207,6 +1378,13 @@ Dsymbol *Package::search(Loc loc, Identifier *ident, int flags)
     return ScopeDsymbol::search(loc, ident, flags);
 }
 
+void Package::addSpellings(Speller *sp)
+{
+    ScopeDsymbol::addSpellings(sp);
+    if (!isModule() && mod)
+        mod->showSpellings(sp);
+}
+
 /* ===========================  ===================== */
 
 /********************************************
@@ -50,6 +50,7 @@ public:
 
     void semantic(Scope *sc) { }
     Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
+    void addSpellings(Speller *sp);
     void accept(Visitor *v) { v->visit(this); }
 
     Module *isPackageMod();
@@ -64,6 +65,15 @@ public:
     static Dsymbols deferred;   // deferred Dsymbol's needing semantic() run on them
     static Dsymbols deferred3;  // deferred Dsymbol's needing semantic3() run on them
     static unsigned dprogress;  // progress resolving the deferred list
+    static FlatAA deferredState;        // whether each deferred Dsymbol is queued or waiting
+    static FlatAA deferredWaiters;      // Dsymbols waiting on each Dsymbol
+    static size_t deferredWaiting;      // number of deferred Dsymbols waiting
+    static unsigned deferredPasses;     // passes made over the deferred list
+    static unsigned deferredRetries;    // semantic() runs on deferred Dsymbols
+    static unsigned searchCacheGeneration;      // bumped to invalidate every module's search cache
+    static unsigned searchCacheHits;
+    static unsigned searchCacheMisses;
+    static bool searchCutShort;         // a search ran into a module already being searched
     static void init();
 
     static AggregateDeclaration *moduleinfo;
@@ -88,17 +98,22 @@ public:
     bool rootImports();         // returns true if module imports root module
 
     int insearch;
-    Identifier *searchCacheIdent;
+    FlatAA searchCache;         // symbols found by search(), by identifier and flags
+    FlatAA searchCacheNotFound; // identifiers and flags search() found nothing for
+    unsigned searchCacheGen;    // searchCacheGeneration the cache is for
+    Identifier *searchCacheIdent;       // last search that was cut short
     Dsymbol *searchCacheSymbol; // cached value of search
     int searchCacheFlags;       // cached flags
 
     Module *importedFrom;       // module from command line we're imported from,
                                 // i.e. a module that will be taken all the
                                 // way to an object file
+    bool quiet;                 // another -j job reports the errors in this module
 
     Dsymbols *decldefs;         // top level declarations for this Module
 
     Modules aimports;             // all imported modules
+    Modules importedAll;          // modules imported by importAll(), before any semantic
 
     unsigned debuglevel;        // debug level
     Strings *debugids;      // debug identifiers
@@ -132,11 +147,15 @@ public:
     Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
     Dsymbol *symtabInsert(Dsymbol *s);
     void deleteObjFile();
-    static void addDeferredSemantic(Dsymbol *s);
+    static void addDeferredSemantic(Dsymbol *s, Dsymbol *waitingOn = NULL);
+    static void wakeDeferredSemantic(Dsymbol *s);
+    static void wakeAllDeferredSemantic();
     static void runDeferredSemantic();
     static void addDeferredSemantic3(Dsymbol *s);
     static void runDeferredSemantic3();
     static void clearCache();
+    static void printSearchStats();
+    static void printDeferredStats();
     int imports(Module *m);
 
     bool isRoot() { return this->importedFrom == this; }
@@ -48,7 +48,9 @@ void out_config_init(
                         // 1: D
                         // 2: fake it with C symbolic debug info
         bool alwaysframe,       // always create standard function frame
-        bool stackstomp         // add stack stomping code
+        bool stackstomp,        // add stack stomping code
+        bool regcolor,          // colour all register candidates in one pass
+        int scheduler           // TARGET_xxx to schedule 64 bit code for, 0 for none
         );
 
 void out_config_debug(
@@ -89,6 +91,14 @@ void backend_init()
     exe = params->pic == 0;
 #endif
 
+    int scheduler = 0;
+    switch (params->cpu)
+    {
+        case CPUskylake:    scheduler = TARGET_Skylake;     break;
+        case CPUzen:        scheduler = TARGET_Zen;         break;
+        default:            break;
+    }
+
     out_config_init(
         (params->is64bit ? 64 : 32) | (params->mscoff ? 1 : 0),
         exe,
@@ -98,7 +108,9 @@ void backend_init()
         params->optimize,
         params->symdebug,
         params->alwaysframe,
-        params->stackstomp
+        params->stackstomp,
+        params->regColor,
+        scheduler
     );
 
 #ifdef DEBUG
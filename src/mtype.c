@@ -123,7 +123,8 @@ Type *Type::tdstring;
 Type *Type::tvalist;
 Type *Type::basic[TMAX];
 unsigned char Type::sizeTy[TMAX];
-StringTable Type::stringtable;
+SharedStringTable Type::stringtable;
+SharedStringTable Type::structtable;
 
 void initTypeMangle();
 void mangleToBuffer(Type *t, OutBuffer *buf);
@@ -198,6 +199,7 @@ char Type::needThisPrefix()
 void Type::init()
 {
     stringtable._init(14000);
+    structtable._init(4000);
 
     for (size_t i = 0; i < TMAX; i++)
         sizeTy[i] = sizeof(TypeBasic);
@@ -1628,6 +1630,61 @@ Lnot:
     return t;
 }
 
+/************************************
+ * What a pointer or array type is made of, which is all its deco
+ * depends on: the kind of type, its mod, the (merged) decos of its
+ * element and key types, and its dimension. Equal keys make equal
+ * decos, so they can be merged by key without being mangled.
+ */
+
+struct TypeKey
+{
+    unsigned char ty;
+    unsigned char mod;
+    const char *next;
+    const char *index;
+    dinteger_t dim;
+
+    bool set(Type *t);
+};
+
+/************************************
+ * Set the key of t.
+ * Returns:
+ *      false if t cannot be merged by key
+ */
+
+bool TypeKey::set(Type *t)
+{
+    memset(this, 0, sizeof(TypeKey));   // the padding is part of the key, too
+    switch (t->ty)
+    {
+        case Taarray:
+            index = ((TypeAArray *)t)->index->merge()->deco;
+            break;
+
+        case Tsarray:
+        {
+            Expression *e = ((TypeSArray *)t)->dim;
+            if (!e || e->op != TOKint64)
+                return false;
+            dim = e->toInteger();
+            break;
+        }
+
+        case Tpointer:
+        case Tarray:
+            break;
+
+        default:
+            return false;
+    }
+    ty = t->ty;
+    mod = t->mod;
+    next = t->nextOf()->deco;
+    return true;
+}
+
 /************************************
  */
 
@@ -1647,6 +1704,20 @@ Type *Type::merge()
     assert(t);
     if (!deco)
     {
+        /* Pointers and arrays are built again and again out of types that
+         * are already merged, and mangling them means copying and hashing
+         * the decos of those all over again. Look them up by what they're
+         * made of first.
+         */
+        TypeKey key;
+        StringValue *skey = NULL;
+        if (key.set(this))
+        {
+            skey = structtable.update((char *)&key, sizeof(key));
+            if (skey->ptrvalue)
+                return (Type *)skey->ptrvalue;
+        }
+
         OutBuffer buf;
         buf.reserve(32);
 
@@ -1665,10 +1736,22 @@ Type *Type::merge()
         }
         else
         {
-            sv->ptrvalue = (char *)(t = stripDefaultArgs(t));
-            deco = t->deco = (char *)sv->toDchars();
+            // Give t its deco before other threads can find it
+            t = stripDefaultArgs(t);
+            t->deco = (char *)sv->toDchars();
+            Type *tm = (Type *)sv->initPtrvalue(t);
+            if (tm == t)
+                deco = t->deco;
+            else
+            {
+                // Another thread merged the same type first
+                t->deco = NULL;
+                t = tm;
+            }
             //printf("new value, deco = '%s' %p\n", t->deco, t->deco);
         }
+        if (skey)
+            skey->initPtrvalue(t);
     }
     return t;
 }
@@ -2117,13 +2200,13 @@ Expression *Type::getProperty(Loc loc, Identifier *ident, int flag)
     }
     else
     {
-        Dsymbol *s = NULL;
-        if (ty == Tstruct || ty == Tclass || ty == Tenum)
-            s = toDsymbol(NULL);
-        if (s)
-            s = s->search_correct(ident);
-        if (this != Type::terror)
+        if (this != Type::terror && !global.gagError())
         {
+            Dsymbol *s = NULL;
+            if (ty == Tstruct || ty == Tclass || ty == Tenum)
+                s = toDsymbol(NULL);
+            if (s)
+                s = s->search_correct(ident);
             if (s)
                 error(loc, "no property '%s' for type '%s', did you mean '%s'?", ident->toChars(), toChars(), s->toChars());
             else
@@ -218,7 +218,8 @@ public:
 
     static Type *basic[TMAX];
     static unsigned char sizeTy[TMAX];
-    static StringTable stringtable;
+    static SharedStringTable stringtable;
+    static SharedStringTable structtable;   // merged types by what they are made of
 
     // These tables are for implicit conversion of binary ops;
     // the indices are the type of operand one, followed by operand two.
@@ -50,7 +50,7 @@ void Nspace::semantic(Scope *sc)
     if (members)
     {
         if (!symtab)
-            symtab = new DsymbolTable();
+            symtab = new DsymbolTable(members->dim);
 
         // The namespace becomes 'imported' into the enclosing scope
         for (Scope *sce = sc; 1; sce = sce->enclosing)
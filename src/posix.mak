@@ -122,6 +122,16 @@ GLUE_FLAGS := -DDMDV2=1 -I$(ROOT) -I$(TK) -I$(C)
 BACK_FLAGS := -DDMDV2=1 -I$(ROOT) -I$(TK) -I$(C) -I.
 ROOT_FLAGS := -DDMDV2=1 -I$(ROOT)
 
+# Define ENABLE_MEM_ARENA to allocate from thread-local arenas, and
+# ENABLE_MEM_STATS to print allocation counts per call site and string
+# table occupancy and probe lengths on exit.
+ifdef ENABLE_MEM_ARENA
+ROOT_FLAGS += -DMEM_ARENA=1
+endif
+ifdef ENABLE_MEM_STATS
+ROOT_FLAGS += -DMEM_STATS=1
+endif
+
 
 DMD_OBJS = \
 	access.o attrib.o \
@@ -138,17 +148,17 @@ DMD_OBJS = \
 	struct.o template.o \
 	version.o utf.o staticassert.o \
 	entity.o doc.o macro.o \
-	hdrgen.o delegatize.o interpret.o traits.o \
+	hdrgen.o delegatize.o interpret.o bytecode.o traits.o \
 	builtin.o ctfeexpr.o clone.o aliasthis.o \
 	arrayop.o json.o unittests.o \
 	imphint.o argtypes.o apply.o sapply.o sideeffect.o \
 	intrange.o canthrow.o target.o nspace.o errors.o \
-	escape.o tokens.o globals.o
+	escape.o tokens.o tokcache.o timetrace.o globals.o
 
 ROOT_OBJS = \
 	rmem.o port.o man.o stringtable.o response.o \
 	aav.o speller.o outbuffer.o object.o \
-	filename.o file.o async.o checkedint.o
+	filename.o file.o checkedint.o
 
 GLUE_OBJS = \
 	glue.o msc.o s2ir.o todt.o e2ir.o tocsym.o \
@@ -195,14 +205,17 @@ SRC = win32.mak posix.mak osmodel.mak \
 	utf.h utf.c staticassert.h staticassert.c \
 	entity.c \
 	doc.h doc.c macro.h macro.c hdrgen.h hdrgen.c arraytypes.h \
-	delegatize.c interpret.c traits.c cppmangle.c \
+	delegatize.c interpret.c bytecode.c traits.c cppmangle.c \
 	builtin.c clone.c lib.h arrayop.c \
 	aliasthis.h aliasthis.c json.h json.c unittests.c imphint.c \
 	argtypes.c apply.c sapply.c sideeffect.c \
 	intrange.h intrange.c canthrow.c target.c target.h \
 	scanmscoff.c scanomf.c ctfe.h ctfeexpr.c \
 	ctfe.h ctfeexpr.c visitor.h nspace.h nspace.c errors.h errors.c \
-	escape.c tokens.h tokens.c globals.h globals.c
+	escape.c tokens.h tokens.c tokcache.h tokcache.c timetrace.h timetrace.c \
+	globals.h globals.c bench/lexer.c bench/stringtable.c bench/symtab.c bench/vec.c \
+	bench/regalloc.c bench/kernels.d bench/regweight.d bench/regcolor.d \
+	bench/sched.c bench/schedbase.d bench/schedskylake.d bench/schedzen.d
 
 ROOT_SRC = $(ROOT)/root.h \
 	$(ROOT)/array.h \
@@ -210,7 +223,7 @@ ROOT_SRC = $(ROOT)/root.h \
 	$(ROOT)/man.c \
 	$(ROOT)/checkedint.h $(ROOT)/checkedint.c \
 	$(ROOT)/stringtable.h $(ROOT)/stringtable.c \
-	$(ROOT)/response.c $(ROOT)/async.h $(ROOT)/async.c \
+	$(ROOT)/response.c \
 	$(ROOT)/aav.h $(ROOT)/aav.c \
 	$(ROOT)/longdouble.h $(ROOT)/longdouble.c \
 	$(ROOT)/speller.h $(ROOT)/speller.c \
@@ -271,8 +284,70 @@ backend.a: $(BACK_OBJS)
 dmd: frontend.a root.a glue.a backend.a
 	$(HOST_CC) -o dmd $(MODEL_FLAG) frontend.a root.a glue.a backend.a $(LDFLAGS)
 
+######## micro-benchmarks, built and run by 'make -f posix.mak bench'
+
+BENCH = lexbench stringtablebench symtabbench vecbench regbench schedbench
+
+bench: $(BENCH)
+	for b in $(BENCH); do ./$$b || exit 1; done
+
+lexbench: bench/lexer.c frontend.a root.a glue.a backend.a
+	$(CC) $(CFLAGS) $(DMD_FLAGS) -I. -o $@ $< frontend.a root.a glue.a backend.a $(LDFLAGS)
+
+stringtablebench: bench/stringtable.c root.a
+	$(CC) $(CFLAGS) $(ROOT_FLAGS) -o $@ $< root.a $(LDFLAGS)
+
+symtabbench: bench/symtab.c root.a
+	$(CC) $(CFLAGS) $(ROOT_FLAGS) -o $@ $< root.a $(LDFLAGS)
+
+vecbench: bench/vec.c backend.a root.a
+	$(CC) $(CFLAGS) $(BACK_FLAGS) -o $@ $< backend.a root.a $(LDFLAGS)
+
+# the kernels are compiled by the dmd just built, once per register allocator
+DRUNTIME_PATH = ../../druntime
+REGBENCH_DFLAGS = -conf= -I$(DRUNTIME_PATH)/import -Ibench -fPIC -O -release -inline -boundscheck=off
+REGBENCH_OBJS = regweight.o regcolor.o kernels.o
+BENCH_KERNELS = dot matmul sieve crc32 mandel stencil collatz
+
+# Start each kernel with prefix $(1) in object $(2) on a page of its own,
+# so the same code is timed from the same place whichever object it is in
+alignkernels = objcopy $(foreach k,$(BENCH_KERNELS),--set-section-alignment .text.$(1)$(k)=4096) $(2)
+
+# Shell commands printing the kernels that have the same code with prefix
+# $(1) in object $(2) as with prefix $(3) in object $(4)
+samekernels = for k in $(BENCH_KERNELS); do \
+	objcopy -O binary -j .text.$(1)$$k $(2) $(2).bin; \
+	objcopy -O binary -j .text.$(3)$$k $(4) $(4).bin; \
+	cmp -s $(2).bin $(4).bin && printf ' %s' $$k; \
+	done; rm -f $(2).bin $(4).bin
+
+regbench: bench/regalloc.c bench/kernels.d bench/regweight.d bench/regcolor.d dmd root.a
+	./dmd $(REGBENCH_DFLAGS) -regalloc=weight -c -ofregweight.o bench/regweight.d
+	./dmd $(REGBENCH_DFLAGS) -regalloc=color -c -ofregcolor.o bench/regcolor.d
+	./dmd $(REGBENCH_DFLAGS) -c -ofkernels.o bench/kernels.d
+	$(call alignkernels,weight_,regweight.o)
+	$(call alignkernels,color_,regcolor.o)
+	$(CC) $(CFLAGS) $(ROOT_FLAGS) -DSAME_CODE="\"$$($(call samekernels,weight_,regweight.o,color_,regcolor.o)) \"" \
+		-o $@ $< $(REGBENCH_OBJS) root.a $(LDFLAGS)
+
+# and once per processor the 64 bit code is scheduled for
+SCHEDBENCH_OBJS = schedbase.o schedskylake.o schedzen.o kernels.o
+
+schedbench: bench/sched.c bench/kernels.d bench/schedbase.d bench/schedskylake.d bench/schedzen.d dmd root.a
+	./dmd $(REGBENCH_DFLAGS) -m64 -mcpu=baseline -c -ofschedbase.o bench/schedbase.d
+	./dmd $(REGBENCH_DFLAGS) -m64 -mcpu=skylake -c -ofschedskylake.o bench/schedskylake.d
+	./dmd $(REGBENCH_DFLAGS) -m64 -mcpu=zen -c -ofschedzen.o bench/schedzen.d
+	./dmd $(REGBENCH_DFLAGS) -c -ofkernels.o bench/kernels.d
+	$(call alignkernels,base_,schedbase.o)
+	$(call alignkernels,skylake_,schedskylake.o)
+	$(call alignkernels,zen_,schedzen.o)
+	$(CC) $(CFLAGS) $(ROOT_FLAGS) \
+		-DSAME_SKYLAKE="\"$$($(call samekernels,base_,schedbase.o,skylake_,schedskylake.o)) \"" \
+		-DSAME_ZEN="\"$$($(call samekernels,base_,schedbase.o,zen_,schedzen.o)) \"" \
+		-o $@ $< $(SCHEDBENCH_OBJS) root.a $(LDFLAGS)
+
 clean:
-	rm -f $(DMD_OBJS) $(ROOT_OBJS) $(GLUE_OBJS) $(BACK_OBJS) dmd optab.o id.o impcnvgen idgen id.c id.h \
+	rm -f $(DMD_OBJS) $(ROOT_OBJS) $(GLUE_OBJS) $(BACK_OBJS) dmd $(BENCH) $(REGBENCH_OBJS) $(SCHEDBENCH_OBJS) optab.o id.o impcnvgen idgen id.c id.h \
 	impcnvtab.c optabgen debtab.c optab.c cdxxx.c elxxx.c fltables.c \
 	tytab.c verstr.h core \
 	*.cov *.deps *.gcda *.gcno *.a
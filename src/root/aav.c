@@ -136,6 +136,24 @@ Value dmd_aaGetRvalue(AA* aa, Key key)
 }
 
 
+/*************************************************
+ * Call fp(arg, key, value) for each entry of the associative array,
+ * in no particular order. fp must not add entries.
+ */
+
+void dmd_aaApply(AA* aa, void (*fp)(void *arg, Key key, Value value), void *arg)
+{
+    if (aa)
+    {
+        for (size_t i = 0; i < aa->b_length; i++)
+        {
+            for (aaA *e = aa->b[i]; e; e = e->next)
+                (*fp)(arg, e->key, e->value);
+        }
+    }
+}
+
+
 /********************************************
  * Rehash an array.
  */
@@ -176,6 +194,122 @@ void dmd_aaRehash(AA** paa)
 }
 
 
+/****************************** FlatAA ******************************/
+
+FlatAA::FlatAA(size_t dim)
+{
+    entries = NULL;
+    capacity = 0;
+    count = 0;
+    if (dim)
+        reserve(dim);
+}
+
+FlatAA::~FlatAA()
+{
+    mem.free(entries);
+}
+
+/*************************************************
+ * Make room for at least dim entries. At most half the entries are
+ * used, so looking up a key that isn't there soon gets to an empty one.
+ */
+
+void FlatAA::reserve(size_t dim)
+{
+    size_t len = capacity ? capacity : 8;
+    while (len < dim * 2)
+        len *= 2;
+    if (len == capacity)
+        return;
+
+    Entry *newentries = (Entry *)mem.malloc(len * sizeof(Entry));
+    memset(newentries, 0, len * sizeof(Entry));
+    for (size_t k = 0; k < capacity; k++)
+    {
+        Entry *e = &entries[k];
+        if (e->value)
+        {
+            size_t j = hash((size_t)e->key) & (len - 1);
+            while (newentries[j].value)
+                j = (j + 1) & (len - 1);
+            newentries[j] = *e;
+        }
+    }
+    mem.free(entries);
+    entries = newentries;
+    capacity = len;
+}
+
+/*************************************************
+ * Remove all entries, keeping the room for them.
+ */
+
+void FlatAA::reset()
+{
+    if (count)
+        memset(entries, 0, capacity * sizeof(Entry));
+    count = 0;
+}
+
+/*************************************************
+ * Get pointer to value indexed by key.
+ * Add entry for key if it is not already there, returning a pointer to a
+ * null Value, which the caller must set.
+ */
+
+Value *FlatAA::get(Key key)
+{
+    if ((count + 1) * 2 > capacity)
+        reserve(count + 1);
+    size_t mask = capacity - 1;
+    for (size_t i = hash((size_t)key) & mask; 1; i = (i + 1) & mask)
+    {
+        Entry *e = &entries[i];
+        if (!e->value)
+        {
+            e->key = key;
+            count++;
+            return &e->value;
+        }
+        if (e->key == key)
+            return &e->value;
+    }
+}
+
+/*************************************************
+ * Get value indexed by key.
+ * Returns NULL if it is not already there.
+ */
+
+Value FlatAA::getRvalue(Key key)
+{
+    if (!count)
+        return NULL;
+    size_t mask = capacity - 1;
+    for (size_t i = hash((size_t)key) & mask; 1; i = (i + 1) & mask)
+    {
+        Entry *e = &entries[i];
+        if (!e->value || e->key == key)
+            return e->value;
+    }
+}
+
+/*************************************************
+ * Call fp(arg, key, value) for each entry, in no particular order.
+ * fp must not add entries.
+ */
+
+void FlatAA::apply(void (*fp)(void *arg, Key key, Value value), void *arg)
+{
+    for (size_t i = 0; i < capacity; i++)
+    {
+        if (entries[i].value)
+            (*fp)(arg, entries[i].key, entries[i].value);
+    }
+}
+
+
 #if UNITTEST
 
 void unittest_aa()
@@ -188,6 +322,15 @@ void unittest_aa()
     *pv = (void *)3;
     v = dmd_aaGetRvalue(aa, NULL);
     assert(v == (void *)3);
+
+    FlatAA faa;
+    assert(!faa.getRvalue(NULL));
+    for (size_t i = 0; i < 100; i++)
+        *faa.get((Key)(i * 8)) = (void *)(i + 1);
+    assert(faa.length() == 100);
+    for (size_t i = 0; i < 100; i++)
+        assert(faa.getRvalue((Key)(i * 8)) == (void *)(i + 1));
+    assert(!faa.getRvalue((Key)(100 * 8)));
 }
 
 #endif
@@ -7,6 +7,11 @@
  * https://github.com/D-Programming-Language/dmd/blob/master/src/root/aav.h
  */
 
+#ifndef AAV_H
+#define AAV_H
+
+#include <stddef.h>
+
 typedef void* Value;
 typedef void* Key;
 
@@ -16,4 +21,35 @@ size_t dmd_aaLen(AA* aa);
 Value* dmd_aaGet(AA** aa, Key key);
 Value dmd_aaGetRvalue(AA* aa, Key key);
 void dmd_aaRehash(AA** paa);
+void dmd_aaApply(AA* aa, void (*fp)(void *arg, Key key, Value value), void *arg);
+
+/* An associative array kept in one open addressed block of entries,
+ * rather than a node per entry, for tables that are looked up much
+ * more than they are added to. Values must not be NULL, and the
+ * pointers returned by get() only last until the next get().
+ */
+struct FlatAA
+{
+    struct Entry
+    {
+        Key key;
+        Value value;            // NULL if the entry is empty
+    };
+
+    Entry *entries;
+    size_t capacity;            // dimension of entries[], a power of 2 or 0
+    size_t count;               // number of entries in use
+
+    FlatAA(size_t dim = 0);
+    ~FlatAA();
+
+    size_t length() { return count; }
+    void reserve(size_t dim);
+    void reset();
+    Value *get(Key key);
+    Value getRvalue(Key key);
+    void apply(void (*fp)(void *arg, Key key, Value value), void *arg);
+};
+
+#endif
 
@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <utime.h>
+#include <sys/mman.h>
 #endif
 
 #include "filename.h"
@@ -40,6 +41,19 @@
 
 /****************************** File ********************************/
 
+#if POSIX
+/* Length of the mapping for a file of size bytes. It is
+ * rounded up to whole pages and leaves room for the sentinel.
+ */
+static size_t mapLength(size_t size)
+{
+    static size_t pagesize;
+    if (!pagesize)
+        pagesize = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + 2 + pagesize - 1) & ~(pagesize - 1);
+}
+#endif
+
 File::File(const FileName *n)
 {
     ref = 0;
@@ -62,6 +76,11 @@ File::File(const char *n)
 }
 
 File::~File()
+{
+    freeBuffer();
+}
+
+void File::freeBuffer()
 {
     if (buffer)
     {
@@ -70,8 +89,13 @@ File::~File()
 #if _WIN32
         if (ref == 2)
             UnmapViewOfFile(buffer);
+#elif POSIX
+        if (ref == 2)
+            munmap(buffer, mapLength(len));
 #endif
     }
+    buffer = NULL;
+    len = 0;
 }
 
 /*************************************
@@ -191,6 +215,109 @@ err1:
 #endif
 }
 
+/*************************************
+ * Read file by mapping it into memory.
+ * Returns:
+ *      false       success
+ */
+
+bool File::mmread()
+{
+    if (len)
+        return false;               // already read the file
+#if POSIX
+    struct stat buf;
+    size_t size;
+    size_t maplen;
+    void *p;
+
+    char *name = this->name->toChars();
+    //printf("File::mmread('%s')\n",name);
+    int fd = open(name, O_RDONLY);
+    if (fd == -1)
+        return true;
+
+    // Pipes, devices and empty files can't be mapped
+    if (fstat(fd, &buf) || !S_ISREG(buf.st_mode) || buf.st_size == 0)
+        goto Lread;
+    size = (size_t)buf.st_size;
+
+    /* Reserve address space for the file and the sentinel with an
+     * anonymous mapping, which reads as 0, then map the file over
+     * the start of it. Whatever the file does not cover becomes
+     * the sentinel, so there is no need to copy the file.
+     */
+    maplen = mapLength(size);
+    p = mmap(NULL, maplen, PROT_READ, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (p == MAP_FAILED)
+        goto Lread;
+    if (mmap(p, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(p, maplen);
+        goto Lread;
+    }
+    close(fd);
+
+#ifdef MADV_WILLNEED
+    // Start reading the pages in now, the lexer will want all of them
+    madvise(p, size, MADV_WILLNEED);
+#endif
+
+    if (!ref)
+        ::free(buffer);
+    ref = 2;
+    buffer = (unsigned char *)p;
+    len = size;
+    return false;
+
+Lread:
+    close(fd);
+    return read();
+#elif _WIN32
+    SYSTEM_INFO si;
+    DWORD size;
+    HANDLE hFileMap;
+    void *p;
+
+    char *name = this->name->toChars();
+    HANDLE h = CreateFileA(name,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return true;
+
+    /* The sentinel comes from the zero filled remainder of the
+     * last page, so the file must not end too close to a page boundary.
+     */
+    GetSystemInfo(&si);
+    size = GetFileSize(h,NULL);
+    if (size == 0 || size == INVALID_FILE_SIZE ||
+        size % si.dwPageSize == 0 || size % si.dwPageSize > si.dwPageSize - 2)
+        goto Lread;
+
+    hFileMap = CreateFileMappingA(h,NULL,PAGE_READONLY,0,size,NULL);
+    if (!hFileMap)
+        goto Lread;
+    p = MapViewOfFile(hFileMap,FILE_MAP_READ,0,0,size);
+    CloseHandle(hFileMap);
+    if (!p)
+        goto Lread;
+    CloseHandle(h);
+
+    if (!ref)
+        ::free(buffer);
+    ref = 2;
+    buffer = (unsigned char *)p;
+    len = size;
+    return false;
+
+Lread:
+    CloseHandle(h);
+    return read();
+#else
+    return read();
+#endif
+}
+
 /*********************************************
  * Write a file.
  * Returns:
@@ -24,7 +24,8 @@ struct FileName;
 
 struct File
 {
-    int ref;                    // != 0 if this is a reference to someone else's buffer
+    int ref;                    // != 0 if this is a reference to someone else's buffer,
+                                // 2 if buffer is a view of the file mapped by mmread()
     unsigned char *buffer;      // data for our file
     size_t len;                 // amount of data in buffer[]
 
@@ -42,6 +43,19 @@ struct File
 
     bool read();
 
+    /* Read file by mapping it into memory where the system supports it,
+     * falling back to read() otherwise. The mapping is read-only and is
+     * followed by the same 0 sentinel that read() appends.
+     * Return true if error
+     */
+
+    bool mmread();
+
+    /* Free or unmap buffer, if we own it
+     */
+
+    void freeBuffer();
+
     /* Write file, return true if error
      */
 
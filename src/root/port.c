@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
+#include <windows.h>
 
 double Port::nan = NAN;
 longdouble Port::ldbl_nan = NAN;
@@ -153,6 +154,16 @@ longdouble Port::strtold(const char *buffer, char **endp)
     return result;
 }
 
+unsigned long long Port::nanoseconds()
+{
+    static LARGE_INTEGER freq;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (unsigned long long)((double)t.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+
 #endif
 
 #if _MSC_VER
@@ -169,6 +180,7 @@ longdouble Port::strtold(const char *buffer, char **endp)
 #include <wchar.h>
 #include <stdlib.h>
 #include <limits> // for std::numeric_limits
+#include <windows.h>
 
 double Port::nan;
 longdouble Port::ldbl_nan;
@@ -367,6 +379,16 @@ longdouble Port::strtold(const char *p, char **endp)
     return ::strtold_dm(p, endp);
 }
 
+unsigned long long Port::nanoseconds()
+{
+    static LARGE_INTEGER freq;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (unsigned long long)((double)t.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+
 #endif
 
 #if __MINGW32__
@@ -382,6 +404,7 @@ longdouble Port::strtold(const char *p, char **endp)
 #include <wchar.h>
 #include <float.h>
 #include <assert.h>
+#include <windows.h>
 
 double Port::nan;
 longdouble Port::ldbl_nan;
@@ -577,6 +600,16 @@ longdouble Port::strtold(const char *p, char **endp)
     return ::__mingw_strtold(p, endp);
 }
 
+unsigned long long Port::nanoseconds()
+{
+    static LARGE_INTEGER freq;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (unsigned long long)((double)t.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+
 #endif
 
 #if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__
@@ -589,6 +622,9 @@ longdouble Port::strtold(const char *p, char **endp)
 #if __FreeBSD__ && __i386__
 #include <ieeefp.h>
 #endif
+#if __APPLE__
+#include <mach/mach_time.h>
+#endif
 #include <time.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -836,6 +872,24 @@ longdouble Port::strtold(const char *p, char **endp)
     return ::strtold(p, endp);
 }
 
+unsigned long long Port::nanoseconds()
+{
+#if __APPLE__
+    // clock_gettime() only came with OS X 10.12
+    static mach_timebase_info_data_t timebase;
+    if (!timebase.denom)
+        mach_timebase_info(&timebase);
+    unsigned long long t = mach_absolute_time();
+    // Split so t * numer can't overflow
+    return t / timebase.denom * timebase.numer +
+           t % timebase.denom * timebase.numer / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
 #endif
 
 #if __sun
@@ -1092,4 +1146,11 @@ longdouble Port::strtold(const char *p, char **endp)
     return ::strtold(p, endp);
 }
 
+unsigned long long Port::nanoseconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 #endif
@@ -68,6 +68,9 @@ struct Port
     static float strtof(const char *p, char **endp);
     static double strtod(const char *p, char **endp);
     static longdouble strtold(const char *p, char **endp);
+
+    // Monotonic clock for measuring elapsed time
+    static unsigned long long nanoseconds();
 };
 
 #endif
@@ -1,4 +1,3 @@
-
 /* Copyright (c) 2000-2014 by Digital Mars
  * All Rights Reserved, written by Walter Bright
  * http://www.digitalmars.com
@@ -13,20 +12,218 @@
 
 #include "rmem.h"
 
-/* This implementation of the storage allocator uses the standard C allocation package.
+#if MEM_ARENA
+#if !(__linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun)
+#error "MEM_ARENA is only implemented for POSIX hosts"
+#endif
+#include <sys/mman.h>
+#include <pthread.h>
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+#endif
+
+#if MEM_STATS && !(__GNUC__ || __clang__)
+#undef MEM_STATS
+#endif
+
+/* This implementation of the storage allocator uses the standard C allocation package,
+ * unless MEM_ARENA is set.
  */
 
 Mem mem;
 
+#if MEM_STATS
+
+/* Allocation counts per call site, keyed by return address.
+ */
+
+struct CallSite
+{
+    void *site;
+    size_t count;
+    size_t bytes;
+};
+
+#define NSITES 4096             // power of 2
+static CallSite sites[NSITES];
+static size_t othercount;       // allocations that didn't fit in sites[]
+static size_t otherbytes;
+
+static void countAlloc(void *site, size_t size)
+{
+    size_t h = ((size_t)site >> 2) * 2654435761u;
+    for (size_t n = 0; n < NSITES; n++)
+    {
+        CallSite *cs = &sites[(h + n) & (NSITES - 1)];
+        void *s = cs->site;
+        if (!s && __sync_bool_compare_and_swap(&cs->site, (void *)NULL, site))
+            s = site;
+        else
+            s = cs->site;
+        if (s == site)
+        {
+            __sync_fetch_and_add(&cs->count, 1);
+            __sync_fetch_and_add(&cs->bytes, size);
+            return;
+        }
+    }
+    __sync_fetch_and_add(&othercount, 1);
+    __sync_fetch_and_add(&otherbytes, size);
+}
+
+static int cmpCallSite(const void *p1, const void *p2)
+{
+    const CallSite *c1 = (const CallSite *)p1;
+    const CallSite *c2 = (const CallSite *)p2;
+    return c1->bytes < c2->bytes ? 1 : c1->bytes > c2->bytes ? -1 : 0;
+}
+
+#define COUNT_ALLOC(size) countAlloc(__builtin_return_address(0), (size))
+
+#else
+
+#define COUNT_ALLOC(size) ((void)0)
+
+#endif
+
+#if MEM_ARENA
+
+/* Bump pointer allocation out of one large reservation of address space,
+ * of which the system only commits the pages that get touched. Each thread
+ * takes ARENA_CHUNK sized pieces of the region and allocates from its own
+ * piece without locking. Memory is never returned to the system, but
+ * freeing or reallocating the most recent allocation of a thread reuses it.
+ *
+ * The blocks Mem hands out are preceded by their size, so realloc() knows
+ * how much to copy. Those of operator new are never freed or reallocated,
+ * and go without.
+ *
+ * If the region can't be reserved or is used up, allocations go to the
+ * standard C allocator; free() and realloc() tell the two apart by address.
+ */
+
+#define ARENA_CHUNK (1024 * 1024)
+#define ARENA_HEADER 16         // size of a block, keeping the alignment
+
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+static size_t arena_base;       // start of reserved region
+static size_t arena_end;        // end of reserved region
+static size_t arena_next;       // start of the unused part of the region
+
+static __thread char *chunkp;   // next free byte in this thread's piece
+static __thread char *chunkend; // end of this thread's piece
+static __thread char *lastp;    // most recent allocation in this thread's piece
+
+static void arena_init()
+{
+    size_t size = sizeof(size_t) == 8 ? (size_t)64 << 30 : (size_t)1 << 30;
+    for (; size >= 16 * ARENA_CHUNK; size >>= 1)
+    {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            arena_base = (size_t)p;
+            arena_next = arena_base;
+            arena_end = arena_base + size;
+            return;
+        }
+    }
+}
+
+static inline bool inArena(void *p)
+{
+    return (size_t)p - arena_base < arena_end - arena_base;
+}
+
+/* Returns NULL if the region is exhausted.
+ */
+static void *arena_alloc(size_t size)
+{
+    // 16 byte alignment is better (and sometimes needed) for doubles
+    size = (size + 15) & ~(size_t)15;
+
+    if (size > (size_t)(chunkend - chunkp))
+    {
+        pthread_once(&arena_once, &arena_init);
+
+        // Big blocks get their own piece and leave the current one alone
+        size_t n = size > ARENA_CHUNK / 4 ? size : ARENA_CHUNK;
+        size_t p = __sync_fetch_and_add(&arena_next, n);
+        if (!arena_base || p + n > arena_end || p + n < p)
+            return NULL;
+        if (n != ARENA_CHUNK)
+            return (void *)p;
+        chunkp = (char *)p;
+        chunkend = (char *)p + n;
+    }
+    lastp = chunkp;
+    chunkp += size;
+    return lastp;
+}
+
+/* Allocate a block that records its size.
+ */
+static void *xmalloc(size_t size)
+{
+    char *p = size <= ~(size_t)0 - 2 * ARENA_HEADER
+            ? (char *)arena_alloc(ARENA_HEADER + size)
+            : NULL;
+    if (!p)
+        return ::malloc(size);
+    *(size_t *)p = size;
+    return p + ARENA_HEADER;
+}
+
+static void *arena_realloc(void *p, size_t size)
+{
+    char *block = (char *)p - ARENA_HEADER;
+    size_t oldsize = *(size_t *)block;
+    if (block == lastp && size <= (size_t)(chunkend - lastp) - ARENA_HEADER)
+    {   // Grow or shrink in place
+        *(size_t *)block = size;
+        chunkp = lastp + ((ARENA_HEADER + size + 15) & ~(size_t)15);
+        return p;
+    }
+    void *pnew = xmalloc(size);
+    if (pnew)
+        memcpy(pnew, p, size < oldsize ? size : oldsize);
+    return pnew;
+}
+
+static void arena_free(void *p)
+{
+    if ((char *)p - ARENA_HEADER == lastp)
+    {
+        chunkp = lastp;
+        lastp = NULL;
+    }
+}
+
+#else
+
+#define xmalloc(size) ::malloc(size)
+
+#endif
+
 char *Mem::strdup(const char *s)
 {
     char *p;
 
     if (s)
     {
+        COUNT_ALLOC(strlen(s) + 1);
+#if MEM_ARENA
+        size_t len = strlen(s) + 1;
+        p = (char *)xmalloc(len);
+        if (p)
+            return (char *)memcpy(p, s, len);
+#else
         p = ::strdup(s);
         if (p)
             return p;
+#endif
         error();
     }
     return NULL;
@@ -39,7 +236,8 @@ void *Mem::malloc(size_t size)
         p = NULL;
     else
     {
-        p = ::malloc(size);
+        COUNT_ALLOC(size);
+        p = xmalloc(size);
         if (!p)
             error();
     }
@@ -53,7 +251,17 @@ void *Mem::calloc(size_t size, size_t n)
         p = NULL;
     else
     {
+        COUNT_ALLOC(size * n);
+#if MEM_ARENA
+        // ::calloc() would check this for us
+        if (n > ~(size_t)0 / size)
+            error();
+        p = xmalloc(size * n);
+        if (p)
+            memset(p, 0, size * n);
+#else
         p = ::calloc(size, n);
+#endif
         if (!p)
             error();
     }
@@ -64,18 +272,29 @@ void *Mem::realloc(void *p, size_t size)
 {
     if (!size)
     {   if (p)
-        {   ::free(p);
+        {   free(p);
             p = NULL;
         }
     }
     else if (!p)
     {
-        p = ::malloc(size);
+        COUNT_ALLOC(size);
+        p = xmalloc(size);
+        if (!p)
+            error();
+    }
+#if MEM_ARENA
+    else if (inArena(p))
+    {
+        COUNT_ALLOC(size);
+        p = arena_realloc(p, size);
         if (!p)
             error();
     }
+#endif
     else
     {
+        COUNT_ALLOC(size);
         void *psave = p;
         p = ::realloc(psave, size);
         if (!p)
@@ -89,7 +308,16 @@ void *Mem::realloc(void *p, size_t size)
 void Mem::free(void *p)
 {
     if (p)
+    {
+#if MEM_ARENA
+        if (inArena(p))
+        {
+            arena_free(p);
+            return;
+        }
+#endif
         ::free(p);
+    }
 }
 
 void *Mem::mallocdup(void *o, size_t size)
@@ -99,7 +327,8 @@ void *Mem::mallocdup(void *o, size_t size)
         p = NULL;
     else
     {
-        p = ::malloc(size);
+        COUNT_ALLOC(size);
+        p = xmalloc(size);
         if (!p)
             error();
         else
@@ -114,6 +343,52 @@ void Mem::error()
     exit(EXIT_FAILURE);
 }
 
+#if MEM_STATS && __linux__
+extern char __executable_start;         // provided by the linker
+#endif
+
+void Mem::printStats()
+{
+#if MEM_STATS
+    size_t nsites = 0;
+    size_t count = othercount;
+    size_t bytes = otherbytes;
+    static CallSite sorted[NSITES];
+    for (size_t i = 0; i < NSITES; i++)
+    {
+        if (sites[i].site)
+        {
+            sorted[nsites++] = sites[i];
+            count += sites[i].count;
+            bytes += sites[i].bytes;
+        }
+    }
+    qsort(sorted, nsites, sizeof(sorted[0]), &cmpCallSite);
+
+    printf("        ---- Allocations ----\n");
+    printf("allocs = %llu\tbytes = %llu\tcall sites = %llu\n",
+        (unsigned long long)count, (unsigned long long)bytes, (unsigned long long)nsites);
+#if MEM_ARENA
+    size_t used = arena_next < arena_end ? arena_next - arena_base : arena_end - arena_base;
+    printf("arena reserved = %llu\tused = %llu\n",
+        (unsigned long long)(arena_end - arena_base), (unsigned long long)used);
+#endif
+    // Offsets into the executable, for addr2line
+#if __linux__
+    size_t base = (size_t)&__executable_start;
+#else
+    size_t base = 0;
+#endif
+    for (size_t i = 0; i < nsites && i < 40; i++)
+    {
+        printf("  %#10llx  allocs = %-10llu bytes = %llu\n",
+            (unsigned long long)((size_t)sorted[i].site - base),
+            (unsigned long long)sorted[i].count, (unsigned long long)sorted[i].bytes);
+    }
+    printf("\n");
+#endif
+}
+
 /* =================================================== */
 
 #if defined(__has_feature)
@@ -124,7 +399,26 @@ void Mem::error()
 
 #if !defined(USE_ASAN_NEW_DELETE)
 
-#if 1
+#if MEM_ARENA
+
+void * operator new(size_t m_size)
+{
+    COUNT_ALLOC(m_size);
+    void *p = arena_alloc(m_size ? m_size : 1);
+    if (!p)
+        p = ::malloc(m_size ? m_size : 1);
+    if (p)
+        return p;
+    printf("Error: out of memory\n");
+    exit(EXIT_FAILURE);
+    return p;
+}
+
+void operator delete(void *p)
+{
+}
+
+#elif 1
 
 /* Allocate, but never release
  */
@@ -138,6 +432,8 @@ static void *heapp;
 
 void * operator new(size_t m_size)
 {
+    COUNT_ALLOC(m_size);
+
     // 16 byte alignment is better (and sometimes needed) for doubles
     m_size = (m_size + 15) & ~15;
 
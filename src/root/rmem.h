@@ -12,6 +12,15 @@
 
 #include <stddef.h>     // for size_t
 
+/* Build time options:
+ *  MEM_ARENA   allocate from per-thread bump pointer arenas carved out of one
+ *              large reservation of address space, never returning memory
+ *              to the system (POSIX only)
+ *  MEM_STATS   count allocations and bytes per call site, reported by
+ *              Mem::printStats() (gcc and clang only), and have
+ *              StringTable::printStats() report probe lengths
+ */
+
 struct Mem
 {
     Mem() { }
@@ -23,6 +32,7 @@ struct Mem
     void free(void *p);
     void *mallocdup(void *o, size_t size);
     void error();
+    void printStats();
 };
 
 extern Mem mem;
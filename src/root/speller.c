@@ -13,231 +13,318 @@
 #include <assert.h>
 #include <limits.h>
 
-#if __sun || _MSC_VER
-#include <alloca.h>
-#endif
-
 #include "speller.h"
+#include "rmem.h"
+#include "aav.h"
 
-const char idchars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+static const char idchars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
 
 /**************************************************
- * combine a new result from the spell checker to
- * find the one with the closest symbol with
- * respect to the cost defined by the search function
- * Input/Output:
- *      p       best found spelling (NULL if none found yet)
- *      cost    cost of p (INT_MAX if none found yet)
- * Input:
- *      np      new found spelling (NULL if none found)
- *      ncost   cost of np if non-NULL
- * Returns:
- *      true    if the cost is less or equal 0
- *      false   otherwise
+ * Set of the characters in name[0 .. len], one bit per identifier
+ * character, and one for all others. An edit changes at most two bits.
  */
-bool combineSpellerResult(void*& p, int& cost, void* np, int ncost)
+
+static unsigned long long charSet(const char *name, size_t len)
 {
-    if (np && ncost < cost)
+    unsigned long long set = 0;
+    for (size_t i = 0; i < len; i++)
     {
-        p = np;
-        cost = ncost;
-        if (cost <= 0)
-            return true;
+        unsigned char c = name[i];
+        unsigned bit;
+        if (c >= 'a' && c <= 'z')
+            bit = c - 'a';
+        else if (c >= 'A' && c <= 'Z')
+            bit = 26 + c - 'A';
+        else if (c >= '0' && c <= '9')
+            bit = 52 + c - '0';
+        else if (c == '_')
+            bit = 62;
+        else
+            bit = 63;
+        set |= 1ULL << bit;
     }
-    return false;
+    return set;
 }
 
-void *spellerY(const char *seed, size_t seedlen, fp_speller_t fp, void *fparg,
-        const char *charset, size_t index, int* cost)
+static unsigned bitCount(unsigned long long x)
 {
-    if (!seedlen)
-        return NULL;
-    assert(seed[seedlen] == 0);
-
-    char tmp[30];
-    char *buf;
-    if (seedlen <= sizeof(tmp) - 2)
-        buf = tmp;
-    else
-    {
-        buf = (char *)alloca(seedlen + 2);    // leave space for extra char
-        if (!buf)
-            return NULL;                      // no matches
-    }
+    unsigned n = 0;
+    for (; x; x &= x - 1)
+        n++;
+    return n;
+}
 
-    memcpy(buf, seed, index);
-    *cost = INT_MAX;
-    void* p = NULL;
-    int ncost;
+/****************************** SpellerIndex ******************************/
 
-    /* Delete at seed[index] */
-    if (index < seedlen)
+SpellerIndex::SpellerIndex()
+{
+    names = NULL;
+    dim = 0;
+    allocdim = 0;
+    sorted = true;
+}
+
+SpellerIndex::~SpellerIndex()
+{
+    mem.free(names);
+}
+
+void SpellerIndex::reset()
+{
+    dim = 0;
+    sorted = true;
+}
+
+void SpellerIndex::add(const char *name)
+{
+    if (dim == allocdim)
     {
-        memcpy(buf + index, seed + index + 1, seedlen - index);
-        assert(buf[seedlen - 1] == 0);
-        void* np = (*fp)(fparg, buf, &ncost);
-        if (combineSpellerResult(p, *cost, np, ncost))
-            return p;
+        allocdim = allocdim ? allocdim * 2 : 16;
+        names = (Name *)mem.realloc(names, allocdim * sizeof(Name));
     }
+    Name *n = &names[dim++];
+    n->name = name;
+    n->len = strlen(name);
+    n->chars = charSet(name, n->len);
+    sorted = false;
+}
 
-    if (charset && *charset)
+static int nameCmp(const void *p1, const void *p2)
+{
+    const SpellerIndex::Name *n1 = (const SpellerIndex::Name *)p1;
+    const SpellerIndex::Name *n2 = (const SpellerIndex::Name *)p2;
+    if (n1->len != n2->len)
+        return n1->len < n2->len ? -1 : 1;
+    return strcmp(n1->name, n2->name);
+}
+
+void SpellerIndex::sort()
+{
+    if (!sorted)
     {
-        /* Substitutions */
-        if (index < seedlen)
-        {
-            memcpy(buf, seed, seedlen + 1);
-            for (const char *s = charset; *s; s++)
-            {
-                buf[index] = *s;
-
-                //printf("sub buf = '%s'\n", buf);
-                void* np = (*fp)(fparg, buf, &ncost);
-                if (combineSpellerResult(p, *cost, np, ncost))
-                    return p;
-            }
-            assert(buf[seedlen] == 0);
-        }
+        qsort(names, dim, sizeof(Name), &nameCmp);
+        sorted = true;
+    }
+}
 
-        /* Insertions */
-        memcpy (buf + index + 1, seed + index, seedlen + 1 - index);
+/****************************** Speller ******************************/
 
-        for (const char *s = charset; *s; s++)
-        {
-            buf[index] = *s;
+Speller::Speller(const char *seed, fp_speller_t fp, void *fparg)
+{
+    this->seed = seed;
+    this->seedlen = strlen(seed);
+    this->seedchars = charSet(seed, seedlen);
+    this->maxdist = seedlen < 4 ? seedlen / 2 : 2;
+    this->fp = fp;
+    this->fparg = fparg;
+    this->visited = NULL;
+    this->best = NULL;
+    this->bestname = NULL;
+    this->bestdist = 0;
+    this->bestcost = INT_MAX;
+    this->bestrank = 0;
+}
 
-            //printf("ins buf = '%s'\n", buf);
-            void* np = (*fp)(fparg, buf, &ncost);
-            if (combineSpellerResult(p, *cost, np, ncost))
-                return p;
-        }
-        assert(buf[seedlen + 1] == 0);
-    }
+/**************************************************
+ * Returns:
+ *      true the first time p is visited, so callers
+ *      walking a graph of name tables see each only once
+ */
 
-    return p;                // return "best" result
+bool Speller::visit(void *p)
+{
+    void **pv = dmd_aaGet(&visited, p);
+    if (*pv)
+        return false;
+    *pv = p;
+    return true;
 }
 
-void *spellerX(const char *seed, size_t seedlen, fp_speller_t fp, void *fparg,
-        const char *charset, int flag)
+void Speller::check(const char *name)
 {
-    if (!seedlen)
-        return NULL;
+    size_t len = strlen(name);
+    check(name, len, charSet(name, len));
+}
 
-    char tmp[30];
-    char *buf;
-    if (seedlen <= sizeof(tmp) - 2)
-        buf = tmp;
-    else
+void Speller::check(SpellerIndex *index)
+{
+    if (!maxdist)
+        return;
+    index->sort();
+
+    // Find the first name that could be close enough
+    size_t minlen = seedlen - maxdist;
+    size_t lo = 0;
+    size_t hi = index->dim;
+    while (lo < hi)
     {
-        buf = (char *)alloca(seedlen + 2);    // leave space for extra char
-        if (!buf)
-            return NULL;                      // no matches
+        size_t mid = (lo + hi) / 2;
+        if (index->names[mid].len < minlen)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-    int cost = INT_MAX, ncost;
-    void *p = NULL, *np;
 
-    /* Deletions */
-    memcpy(buf, seed + 1, seedlen);
-    for (size_t i = 0; i < seedlen; i++)
+    for (size_t i = lo; i < index->dim; i++)
     {
-        //printf("del buf = '%s'\n", buf);
-        if (flag)
-            np = spellerY(buf, seedlen - 1, fp, fparg, charset, i, &ncost);
-        else
-            np = (*fp)(fparg, buf, &ncost);
-        if (combineSpellerResult(p, cost, np, ncost))
-            return p;
-
-        buf[i] = seed[i];
+        SpellerIndex::Name *n = &index->names[i];
+        if (n->len > seedlen + maxdist)
+            break;
+        check(n->name, n->len, n->chars);
     }
+}
 
-    /* Transpositions */
-    if (!flag)
+void Speller::check(const char *name, size_t len, unsigned long long chars)
+{
+    if (!maxdist ||
+        len + maxdist < seedlen || len > seedlen + maxdist ||
+        bitCount(chars ^ seedchars) > 2 * maxdist)
+        return;
+
+    size_t dist = distance(name, len);
+    if (dist > maxdist)
+        return;
+    if (best && dist > bestdist)
+        return;
+
+    int cost;
+    void *p = (*fp)(fparg, name, &cost);
+    if (!p)
+        return;
+
+    /* Fewest edits first, then lowest cost, then the order the edits
+     * used to be tried in when this looked up every edit of the seed,
+     * and finally the name so the result doesn't depend on the order
+     * names are shown in.
+     */
+    unsigned r = dist == 1 ? rank(name, len) : 0;
+    if (best)
     {
-        memcpy(buf, seed, seedlen + 1);
-        for (size_t i = 0; i + 1 < seedlen; i++)
+        if (dist != bestdist)
         {
-            // swap [i] and [i + 1]
-            buf[i] = seed[i + 1];
-            buf[i + 1] = seed[i];
-
-            //printf("tra buf = '%s'\n", buf);
-            if (combineSpellerResult(p, cost, (*fp)(fparg, buf, &ncost), ncost))
-                return p;
-
-            buf[i] = seed[i];
+            if (dist > bestdist)
+                return;
         }
-    }
-
-    if (charset && *charset)
-    {
-        /* Substitutions */
-        memcpy(buf, seed, seedlen + 1);
-        for (size_t i = 0; i < seedlen; i++)
+        else if (cost != bestcost)
         {
-            for (const char *s = charset; *s; s++)
-            {
-                buf[i] = *s;
-
-                //printf("sub buf = '%s'\n", buf);
-                if (flag)
-                    np = spellerY(buf, seedlen, fp, fparg, charset, i + 1, &ncost);
-                else
-                    np = (*fp)(fparg, buf, &ncost);
-                if (combineSpellerResult(p, cost, np, ncost))
-                    return p;
-            }
-            buf[i] = seed[i];
+            if (cost > bestcost)
+                return;
         }
-
-        /* Insertions */
-        memcpy(buf + 1, seed, seedlen + 1);
-        for (size_t i = 0; i <= seedlen; i++)      // yes, do seedlen+1 iterations
+        else if (r != bestrank)
         {
-            for (const char *s = charset; *s; s++)
-            {
-                buf[i] = *s;
-
-                //printf("ins buf = '%s'\n", buf);
-                if (flag)
-                    np = spellerY(buf, seedlen + 1, fp, fparg, charset, i + 1, &ncost);
-                else
-                    np = (*fp)(fparg, buf, &ncost);
-                if (combineSpellerResult(p, cost, np, ncost))
-                    return p;
-            }
-            buf[i] = seed[i];   // going past end of seed[] is ok, as we hit the 0
+            if (r > bestrank)
+                return;
         }
+        else if (strcmp(name, bestname) >= 0)
+            return;
     }
-
-    return p;                // return "best" result
+    best = p;
+    bestname = name;
+    bestdist = dist;
+    bestcost = cost;
+    bestrank = r;
 }
 
 /**************************************************
- * Looks for correct spelling.
- * Currently only looks a 'distance' of one from the seed[].
- * This does an exhaustive search, so can potentially be very slow.
- * Input:
- *      seed            wrongly spelled word
- *      fp              search function
- *      fparg           argument to search function
- *      charset         character set
+ * The edits are the ones the speller used to try on the seed: one
+ * deletion, transposition, substitution or insertion, or two of them
+ * next to each other. Either way, name[0 .. len] is the seed with a run
+ * of at most two characters replaced by at most two others, which come
+ * from idchars[]. A substitution by the same character counts as an
+ * edit, so the seed itself is one edit away.
  * Returns:
- *      NULL            no correct spellings found
- *      void*           value returned by fp() for first possible correct spelling
+ *      1 or 2 edits, or maxdist + 1 if name is farther away
+ */
+
+size_t Speller::distance(const char *name, size_t len)
+{
+    size_t n = seedlen < len ? seedlen : len;
+    size_t pre = 0;
+    while (pre < n && seed[pre] == name[pre])
+        pre++;
+    size_t suf = 0;
+    while (suf < n - pre && seed[seedlen - 1 - suf] == name[len - 1 - suf])
+        suf++;
+
+    // seed[pre .. seedlen - suf] was replaced by name[pre .. len - suf]
+    size_t from = seedlen - pre - suf;
+    size_t to = len - pre - suf;
+    if (from == 2 && to == 2 && seed[pre] == name[pre + 1] && seed[pre + 1] == name[pre])
+        return 1;               // transposition
+    for (size_t i = pre; i < len - suf; i++)
+    {
+        if (!strchr(idchars, name[i]))
+            return maxdist + 1;
+    }
+    if (from <= 1 && to <= 1)
+        return 1;
+    if (from <= 2 && to <= 2)
+        return 2;
+    return maxdist + 1;
+}
+
+/**************************************************
+ * Order of a name one edit away from the seed among the edits of the seed:
+ * deletions, then transpositions, substitutions and insertions, each
+ * from left to right and in the order of idchars[].
  */
 
-void *speller(const char *seed, fp_speller_t fp, void *fparg, const char *charset)
+unsigned Speller::rank(const char *name, size_t len)
 {
-    size_t seedlen = strlen(seed);
-    size_t maxdist = seedlen < 4 ? seedlen / 2 : 2;
-    for (int distance = 0; distance < maxdist; distance++)
-    {   void *p = spellerX(seed, seedlen, fp, fparg, charset, distance);
-        if (p)
-            return p;
-//      if (seedlen > 10)
-//          break;
+    size_t i = 0;
+    while (i < seedlen && i < len && seed[i] == name[i])
+        i++;
+
+    unsigned kind;
+    char c = 0;
+    if (len + 1 == seedlen)
+    {
+        // Deletion, of the first of a run of equal characters
+        kind = 0;
+        while (i > 0 && seed[i - 1] == seed[i])
+            i--;
     }
-    return NULL;   // didn't find it
+    else if (len == seedlen + 1)
+    {
+        // Insertion, before a run of the same character
+        kind = 3;
+        c = name[i];
+        while (i > 0 && seed[i - 1] == c)
+            i--;
+    }
+    else if (i == len)
+    {
+        // The seed itself: a transposition of two equal characters,
+        // or a substitution by the same character
+        for (i = 0; i + 1 < len; i++)
+        {
+            if (seed[i] == seed[i + 1])
+                break;
+        }
+        if (i + 1 < len)
+            kind = 1;
+        else
+        {
+            kind = 2;
+            for (i = 0; i < len && !strchr(idchars, seed[i]); i++)
+            { }
+            c = seed[i];
+        }
+    }
+    else if (i + 1 < len && seed[i] == name[i + 1] && seed[i + 1] == name[i] &&
+             memcmp(seed + i + 2, name + i + 2, len - i - 2) == 0)
+        kind = 1;               // transposition
+    else
+    {
+        kind = 2;               // substitution
+        c = name[i];
+    }
+
+    const char *pc = c ? strchr(idchars, c) : NULL;
+    size_t ic = pc ? pc - idchars : sizeof(idchars);
+    if (i > 0xFFFF)
+        i = 0xFFFF;
+    return (kind << 24) | ((unsigned)i << 7) | (unsigned)ic;
 }
 
 
@@ -251,9 +338,7 @@ void *speller_test(void *fparg, const char *s, int* cost)
 {
     //printf("speller_test(%s, %s)\n", fparg, s);
     *cost = 0;
-    if (strcmp((char *)fparg, s) == 0)
-        return fparg;
-    return NULL;
+    return (void *)s;
 }
 
 void unittest_speller()
@@ -274,21 +359,49 @@ void unittest_speller()
         { "hello", "helxxlo", "y" },
         { "hello", "ehlxxlo", "n" },
         { "hello", "heaao", "y" },
+        { "hello", "hello", "y" },
+        { "hello", "hexxxo", "n" },
+        { "hello", "helxo", "y" },
+        { "hello", "hel\xc3\xa9o", "n" },
+        { "ab", "ba", "y" },
+        { "ab", "abc", "y" },
+        { "ab", "a", "y" },
+        { "ab", "ac", "y" },
+        { "ab", "cd", "n" },
+        { "a", "b", "n" },
         { "_123456789_123456789_123456789_123456789", "_123456789_123456789_123456789_12345678", "y" },
         { NULL, NULL, NULL }
     };
     //printf("unittest_speller()\n");
-    const void *p = speller("hello", &speller_test, (void *)"hell", idchars);
-    assert(p != NULL);
     for (int i = 0; cases[i][0]; i++)
     {
         //printf("case [%d]\n", i);
-        void *p = speller(cases[i][0], &speller_test, (void *)cases[i][1], idchars);
-        if (p)
+        Speller sp(cases[i][0], &speller_test, NULL);
+        sp.check(cases[i][1]);
+        if (sp.result())
             assert(cases[i][2][0] == 'y');
         else
             assert(cases[i][2][0] == 'n');
     }
+
+    // Fewer edits win, then the edit that comes first
+    SpellerIndex index;
+    index.add("helo");
+    index.add("hxllo");
+    index.add("hellxx");
+    index.add("xhello");
+    index.add("world");
+    Speller sp("hello", &speller_test, NULL);
+    assert(sp.visit(&index));
+    assert(!sp.visit(&index));
+    sp.check(&index);
+    assert(strcmp((const char *)sp.result(), "helo") == 0);
+
+    Speller sp2("hello", &speller_test, NULL);
+    sp2.check("hellxx");
+    sp2.check("xhello");
+    sp2.check("hxllo");
+    assert(strcmp((const char *)sp2.result(), "hxllo") == 0);
     //printf("unittest_speller() success\n");
 }
 
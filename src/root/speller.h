@@ -7,9 +7,77 @@
  * https://github.com/D-Programming-Language/dmd/blob/master/src/root/speller.h
  */
 
+#ifndef SPELLER_H
+#define SPELLER_H
+
+#if __SC__
+#pragma once
+#endif
+
+#include <stddef.h>
+
+struct AA;
+
 typedef void *(fp_speller_t)(void *, const char *, int*);
 
-extern const char idchars[];
+/* Names to look for a correct spelling in, sorted by length so only
+ * the names about as long as the misspelled one are compared with it.
+ */
+struct SpellerIndex
+{
+    struct Name
+    {
+        const char *name;
+        size_t len;
+        unsigned long long chars;       // set of characters in name
+    };
+
+    Name *names;
+    size_t dim;
+    size_t allocdim;
+    bool sorted;
+
+    SpellerIndex();
+    ~SpellerIndex();
+    void reset();
+    void add(const char *name);
+    void sort();
+};
+
+/* Looks for the correct spelling of a misspelled name, the seed, among
+ * the names it is shown. Only names one edit away from the seed, or for
+ * seeds of 4 or more characters two adjacent edits away, are passed to
+ * the search function, which returns what the name stands for and how
+ * far away it is. An edit inserts, deletes, substitutes or transposes a
+ * character. Fewer edits beat a lower cost.
+ */
+struct Speller
+{
+    Speller(const char *seed, fp_speller_t fp, void *fparg);
+
+    void check(const char *name);
+    void check(SpellerIndex *index);
+    bool visit(void *p);        // true the first time p is visited
+    void *result() { return best; }
+
+private:
+    const char *seed;
+    size_t seedlen;
+    unsigned long long seedchars;
+    size_t maxdist;             // most edits to look for
+    fp_speller_t *fp;
+    void *fparg;
+    AA *visited;
+
+    void *best;                 // best result of fp so far
+    const char *bestname;
+    size_t bestdist;
+    int bestcost;
+    unsigned bestrank;
 
-void *speller(const char *seed, fp_speller_t fp, void *fparg, const char *charset);
+    void check(const char *name, size_t len, unsigned long long chars);
+    size_t distance(const char *name, size_t len);
+    unsigned rank(const char *name, size_t len);
+};
 
+#endif
@@ -23,46 +23,20 @@
 // MurmurHash2 was written by Austin Appleby, and is placed in the public
 // domain. The author hereby disclaims copyright to this source code.
 // https://sites.google.com/site/murmurhash/
-static uint32_t calcHash(const char *key, size_t len)
+// Unlike there, the length is mixed in at the end rather than the start.
+hash_t StringHash::finish(const char *p, size_t n, size_t length)
 {
-    // 'm' and 'r' are mixing constants generated offline.
-    // They're not really 'magic', they just happen to work well.
-
-    const uint32_t m = 0x5bd1e995;
-    const int r = 24;
-
-    // Initialize the hash to a 'random' value
-
-    uint32_t h = (uint32_t)len;
-
-    // Mix 4 bytes at a time into the hash
-
-    const uint8_t *data = (const uint8_t *)key;
-
-    while(len >= 4)
-    {
-        uint32_t k = data[3] << 24 | data[2] << 16 | data[1] << 8 | data[0];
-
-        k *= m;
-        k ^= k >> r;
-        k *= m;
-
-        h *= m;
-        h ^= k;
-
-        data += 4;
-        len -= 4;
-    }
-
     // Handle the last few bytes of the input array
 
-    switch(len & 3)
+    const uint8_t *data = (const uint8_t *)p;
+    switch (n)
     {
     case 3: h ^= data[2] << 16;
     case 2: h ^= data[1] << 8;
     case 1: h ^= data[0];
-        h *= m;
     };
+    h ^= (uint32_t)length;
+    h *= m;
 
     // Do a few final mixes of the hash to ensure the last few
     // bytes are well-incorporated.
@@ -74,6 +48,16 @@ static uint32_t calcHash(const char *key, size_t len)
     return h;
 }
 
+hash_t StringTable::calcHash(const char *s, size_t len)
+{
+    StringHash hash;
+    hash.init();
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+        hash.word(s + i);
+    return hash.finish(s + i, len - i, len);
+}
+
 struct StringEntry
 {
     uint32_t hash;
@@ -173,7 +157,11 @@ size_t StringTable::findSlot(hash_t hash, const char *s, size_t length)
 
 StringValue *StringTable::lookup(const char *s, size_t length)
 {
-    const hash_t hash = calcHash(s, length);
+    return lookup(s, length, calcHash(s, length));
+}
+
+StringValue *StringTable::lookup(const char *s, size_t length, hash_t hash)
+{
     const size_t i = findSlot(hash, s, length);
     // printf("lookup %.*s %p\n", (int)length, s, table[i].value ?: NULL);
     return getValue(table[i].vptr);
@@ -181,7 +169,11 @@ StringValue *StringTable::lookup(const char *s, size_t length)
 
 StringValue *StringTable::update(const char *s, size_t length)
 {
-    const hash_t hash = calcHash(s, length);
+    return update(s, length, calcHash(s, length));
+}
+
+StringValue *StringTable::update(const char *s, size_t length, hash_t hash)
+{
     size_t i = findSlot(hash, s, length);
     if (!table[i].vptr)
     {
@@ -199,7 +191,11 @@ StringValue *StringTable::update(const char *s, size_t length)
 
 StringValue *StringTable::insert(const char *s, size_t length)
 {
-    const hash_t hash = calcHash(s, length);
+    return insert(s, length, calcHash(s, length));
+}
+
+StringValue *StringTable::insert(const char *s, size_t length, hash_t hash)
+{
     size_t i = findSlot(hash, s, length);
     if (table[i].vptr)
         return NULL; // already in table
@@ -230,3 +226,420 @@ void StringTable::grow()
     }
     mem.free(otab);
 }
+
+#if MEM_STATS
+// Histogram of the probes it takes to find the strings in a table
+struct ProbeStats
+{
+    size_t probes[9];                   // the last counts 9 and more
+    size_t total;
+    size_t max;
+
+    void init()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    // Walk the probe sequence of the entry with hash in slot i until it gets there
+    void add(hash_t hash, size_t i, size_t dim)
+    {
+        size_t n = 1;
+        for (size_t k = hash & (dim - 1), j = 1; k != i; ++j, ++n)
+            k = (k + j) & (dim - 1);
+
+        probes[n < 9 ? n - 1 : 8]++;
+        total += n;
+        if (n > max)
+            max = n;
+    }
+
+    void print(size_t count)
+    {
+        printf("probes: average = %.2f\tmax = %llu\n",
+            count ? (double)total / count : 0.0, (unsigned long long)max);
+        for (size_t n = 0; n < 9; ++n)
+        {
+            if (probes[n])
+                printf("  %s%llu\t%llu\n", n < 8 ? "" : ">=", (unsigned long long)(n + 1), (unsigned long long)probes[n]);
+        }
+    }
+};
+#endif
+
+/********************************
+ * Print how full the table is, and how many probes it takes
+ * to find the strings in it, when built with MEM_STATS.
+ */
+
+void StringTable::printStats(const char *name)
+{
+#if MEM_STATS
+    ProbeStats ps;
+    ps.init();
+    for (size_t i = 0; i < tabledim; ++i)
+    {
+        if (table[i].vptr)
+            ps.add(table[i].hash, i, tabledim);
+    }
+
+    printf("        ---- String table %s ----\n", name);
+    printf("strings = %llu\tslots = %llu\tload = %.2f\tpools = %llu\n",
+        (unsigned long long)count, (unsigned long long)tabledim,
+        (double)count / tabledim, (unsigned long long)npools);
+    ps.print(count);
+#endif
+}
+
+/****************************** Atomics ******************************/
+
+#if _WIN32
+#include <windows.h>
+#if _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#include <pthread.h>
+#endif
+
+/* Pointers that other threads look at without taking a lock are read with
+ * acquire and written with release semantics, so whatever they point to is
+ * seen fully built.
+ */
+static inline void *loadAcquire(void *const *p)
+{
+#if __GNUC__
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+    void *v = *(void *const volatile *)p;
+#if _MSC_VER
+    _ReadWriteBarrier();
+#endif
+    return v;
+#endif
+}
+
+static inline void storeRelease(void **p, void *v)
+{
+#if __GNUC__
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+#else
+#if _MSC_VER
+    _ReadWriteBarrier();
+#endif
+    *(void *volatile *)p = v;
+#endif
+}
+
+// Returns: the value *p had, which is old if *p is now v
+static inline void *compareAndSwap(void **p, void *old, void *v)
+{
+#if __GNUC__
+    return __sync_val_compare_and_swap(p, old, v);
+#elif _MSC_VER
+    return InterlockedCompareExchangePointer(p, v, old);
+#else
+    // No threads
+    void *prev = *p;
+    if (prev == old)
+        *p = v;
+    return prev;
+#endif
+}
+
+void *StringValue::initPtrvalue(void *p)
+{
+    void *prev = compareAndSwap(&ptrvalue, NULL, p);
+    return prev ? prev : p;
+}
+
+/****************************** SharedStringTable ******************************/
+
+#define SHARD_BITS 4
+#define NSHARDS (1U << SHARD_BITS)
+
+struct SharedEntry
+{
+    uint32_t hash;
+    StringValue *value;         // NULL if the slot is empty; set last
+};
+
+struct SharedTable
+{
+    size_t dim;                 // power of 2
+    SharedTable *prev;          // the table this one replaced
+    SharedEntry entries[1];     // [dim]
+};
+
+struct StringTableShard
+{
+    SharedTable *table;         // replaced, never changed in place, once it is full
+    size_t count;
+
+    // StringValues are carved out of chunks, each of which starts
+    // with a pointer to the one before it
+    uint8_t *chunk;
+    size_t chunkfill;
+
+#if _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+
+    char pad[64];               // keep the locks of shards off each other's cache lines
+};
+
+static void lockShard(StringTableShard *sh)
+{
+#if _WIN32
+    EnterCriticalSection(&sh->lock);
+#else
+    pthread_mutex_lock(&sh->lock);
+#endif
+}
+
+static void unlockShard(StringTableShard *sh)
+{
+#if _WIN32
+    LeaveCriticalSection(&sh->lock);
+#else
+    pthread_mutex_unlock(&sh->lock);
+#endif
+}
+
+static SharedTable *newTable(size_t dim)
+{
+    SharedTable *t = (SharedTable *)mem.calloc(1, sizeof(SharedTable) + (dim - 1) * sizeof(SharedEntry));
+    t->dim = dim;
+    return t;
+}
+
+static inline StringTableShard *shardOf(StringTableShard *shards, hash_t hash)
+{
+    // The low bits pick the slot, so use the high ones
+    return &shards[(hash >> (32 - SHARD_BITS)) & (NSHARDS - 1)];
+}
+
+/* Look for s in t, without a lock.
+ * Returns:
+ *      its StringValue, or NULL and the empty slot it would go into in *pi
+ */
+static StringValue *findShared(SharedTable *t, hash_t hash, const char *s, size_t length, size_t *pi)
+{
+    for (size_t i = hash & (t->dim - 1), j = 1; ; ++j)
+    {
+        SharedEntry *e = &t->entries[i];
+        StringValue *sv = (StringValue *)loadAcquire((void *const *)&e->value);
+        if (!sv)
+        {
+            *pi = i;
+            return NULL;
+        }
+        if (e->hash == hash && sv->length == length && ::memcmp(s, sv->lstring(), length) == 0)
+            return sv;
+        i = (i + j) & (t->dim - 1);
+    }
+}
+
+static StringValue *allocShared(StringTableShard *sh, const char *s, size_t length)
+{
+    const size_t nbytes = sizeof(StringValue) + length + 1;
+    const size_t header = sizeof(uint8_t *) + (-sizeof(uint8_t *) & 7);
+
+    if (!sh->chunk || sh->chunkfill + nbytes > POOL_SIZE)
+    {
+        size_t size = header + nbytes > POOL_SIZE ? header + nbytes : POOL_SIZE;
+        uint8_t *chunk = (uint8_t *)mem.malloc(size);
+        *(uint8_t **)chunk = sh->chunk;
+        sh->chunk = chunk;
+        sh->chunkfill = header;
+    }
+
+    StringValue *sv = (StringValue *)&sh->chunk[sh->chunkfill];
+    sv->ptrvalue = NULL;
+    sv->length = length;
+    ::memcpy(sv->lstring(), s, length);
+    sv->lstring()[length] = 0;
+    sh->chunkfill += nbytes + (-nbytes & 7); // align to 8 bytes
+    return sv;
+}
+
+static void growShared(StringTableShard *sh)
+{
+    SharedTable *ot = sh->table;
+    SharedTable *t = newTable(ot->dim * 2);
+    for (size_t i = 0; i < ot->dim; ++i)
+    {
+        SharedEntry *e = &ot->entries[i];
+        if (!e->value)
+            continue;
+        size_t k;
+        findShared(t, e->hash, e->value->lstring(), e->value->length, &k);
+        t->entries[k] = *e;
+    }
+    t->prev = ot;
+    storeRelease((void **)&sh->table, t);
+}
+
+void SharedStringTable::_init(size_t size)
+{
+    size = nextpow2((size_t)(size / NSHARDS / loadFactor));
+    if (size < 32) size = 32;
+    shards = (StringTableShard *)mem.calloc(NSHARDS, sizeof(StringTableShard));
+    for (size_t i = 0; i < NSHARDS; ++i)
+    {
+        StringTableShard *sh = &shards[i];
+        sh->table = newTable(size);
+#if _WIN32
+        InitializeCriticalSection(&sh->lock);
+#else
+        pthread_mutex_init(&sh->lock, NULL);
+#endif
+    }
+}
+
+void SharedStringTable::release()
+{
+    if (!shards)
+        return;
+    for (size_t i = 0; i < NSHARDS; ++i)
+    {
+        StringTableShard *sh = &shards[i];
+        for (SharedTable *t = sh->table; t; )
+        {
+            SharedTable *prev = t->prev;
+            mem.free(t);
+            t = prev;
+        }
+        for (uint8_t *chunk = sh->chunk; chunk; )
+        {
+            uint8_t *prev = *(uint8_t **)chunk;
+            mem.free(chunk);
+            chunk = prev;
+        }
+#if _WIN32
+        DeleteCriticalSection(&sh->lock);
+#else
+        pthread_mutex_destroy(&sh->lock);
+#endif
+    }
+    mem.free(shards);
+    shards = NULL;
+}
+
+void SharedStringTable::reset(size_t size)
+{
+    release();
+    _init(size);
+}
+
+SharedStringTable::~SharedStringTable()
+{
+    release();
+}
+
+StringValue *SharedStringTable::lookup(const char *s, size_t length)
+{
+    return lookup(s, length, StringTable::calcHash(s, length));
+}
+
+StringValue *SharedStringTable::lookup(const char *s, size_t length, hash_t hash)
+{
+    StringTableShard *sh = shardOf(shards, hash);
+    size_t i;
+    return findShared((SharedTable *)loadAcquire((void *const *)&sh->table), hash, s, length, &i);
+}
+
+/* Find s in sh, or add it.
+ * Returns:
+ *      its StringValue, and whether it was added in *padded
+ */
+static StringValue *updateShared(StringTableShard *sh, const char *s, size_t length, hash_t hash, bool *padded)
+{
+    *padded = false;
+    size_t i;
+    StringValue *sv = findShared((SharedTable *)loadAcquire((void *const *)&sh->table), hash, s, length, &i);
+    if (sv)
+        return sv;
+
+    // Look again with the lock held, as it may have been added since
+    lockShard(sh);
+    sv = findShared(sh->table, hash, s, length, &i);
+    if (!sv)
+    {
+        if (++sh->count > sh->table->dim * loadFactor)
+        {
+            growShared(sh);
+            findShared(sh->table, hash, s, length, &i);
+        }
+        sv = allocShared(sh, s, length);
+        SharedEntry *e = &sh->table->entries[i];
+        e->hash = (uint32_t)hash;
+        storeRelease((void **)&e->value, sv);
+        *padded = true;
+    }
+    unlockShard(sh);
+    return sv;
+}
+
+StringValue *SharedStringTable::update(const char *s, size_t length)
+{
+    return update(s, length, StringTable::calcHash(s, length));
+}
+
+StringValue *SharedStringTable::update(const char *s, size_t length, hash_t hash)
+{
+    bool added;
+    return updateShared(shardOf(shards, hash), s, length, hash, &added);
+}
+
+StringValue *SharedStringTable::insert(const char *s, size_t length)
+{
+    return insert(s, length, StringTable::calcHash(s, length));
+}
+
+StringValue *SharedStringTable::insert(const char *s, size_t length, hash_t hash)
+{
+    bool added;
+    StringValue *sv = updateShared(shardOf(shards, hash), s, length, hash, &added);
+    return added ? sv : NULL;   // NULL if already in table
+}
+
+/********************************
+ * Print how full the shards are, and how many probes it takes
+ * to find the strings in them, when built with MEM_STATS.
+ */
+
+void SharedStringTable::printStats(const char *name)
+{
+#if MEM_STATS
+    ProbeStats ps;
+    ps.init();
+    size_t count = 0;
+    size_t slots = 0;
+    size_t mincount = ~(size_t)0;
+    size_t maxcount = 0;
+    for (size_t k = 0; k < NSHARDS; ++k)
+    {
+        StringTableShard *sh = &shards[k];
+        SharedTable *t = sh->table;
+        for (size_t i = 0; i < t->dim; ++i)
+        {
+            if (t->entries[i].value)
+                ps.add(t->entries[i].hash, i, t->dim);
+        }
+        count += sh->count;
+        slots += t->dim;
+        if (sh->count < mincount)
+            mincount = sh->count;
+        if (sh->count > maxcount)
+            maxcount = sh->count;
+    }
+
+    printf("        ---- String table %s ----\n", name);
+    printf("strings = %llu\tslots = %llu\tload = %.2f\tshards = %u\tper shard = %llu .. %llu\n",
+        (unsigned long long)count, (unsigned long long)slots, (double)count / slots,
+        NSHARDS, (unsigned long long)mincount, (unsigned long long)maxcount);
+    ps.print(count);
+#endif
+}
@@ -29,9 +29,45 @@ struct StringValue
     size_t len() const { return length; }
     const char *toDchars() const { return (char *)(this + 1); }
 
+    /* Set ptrvalue to p if it is still NULL, for values that several
+     * threads may set at once. Returns what ptrvalue ended up being.
+     */
+    void *initPtrvalue(void *p);
+
     StringValue();  // not constructible
 };
 
+/* MurmurHash2 of a string, mixed in 4 bytes at a time followed by the
+ * last 0 to 3, so the lexer can hash an identifier while it scans it.
+ */
+struct StringHash
+{
+    uint32_t h;
+
+    void init() { h = 0; }
+
+    void word(const char *p)
+    {
+        const uint8_t *data = (const uint8_t *)p;
+        uint32_t k = data[3] << 24 | data[2] << 16 | data[1] << 8 | data[0];
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h *= m;
+        h ^= k;
+    }
+
+    hash_t finish(const char *p, size_t n, size_t length);
+
+private:
+    // 'm' and 'r' are mixing constants generated offline.
+    // They're not really 'magic', they just happen to work well.
+    static const uint32_t m = 0x5bd1e995;
+    static const int r = 24;
+};
+
 struct StringTable
 {
 private:
@@ -53,6 +89,14 @@ public:
     StringValue *insert(const char *s, size_t len);
     StringValue *update(const char *s, size_t len);
 
+    // With hash already computed by calcHash() or StringHash
+    StringValue *lookup(const char *s, size_t len, hash_t hash);
+    StringValue *insert(const char *s, size_t len, hash_t hash);
+    StringValue *update(const char *s, size_t len, hash_t hash);
+
+    static hash_t calcHash(const char *s, size_t len);
+    void printStats(const char *name);
+
 private:
     uint32_t allocValue(const char *p, size_t length);
     StringValue *getValue(uint32_t validx);
@@ -60,4 +104,36 @@ private:
     void grow();
 };
 
+struct StringTableShard;
+
+/* A StringTable that several threads can use at once. Strings are spread
+ * over shards by their hash. Looking up a string takes no lock; adding
+ * one locks its shard. StringValues never move, and tables a shard has
+ * outgrown are kept until reset(), for threads still looking in them.
+ */
+struct SharedStringTable
+{
+private:
+    StringTableShard *shards;
+
+public:
+    void _init(size_t size = 0);
+    void reset(size_t size = 0);
+    ~SharedStringTable();
+
+    StringValue *lookup(const char *s, size_t len);
+    StringValue *insert(const char *s, size_t len);
+    StringValue *update(const char *s, size_t len);
+
+    // With hash already computed by StringTable::calcHash() or StringHash
+    StringValue *lookup(const char *s, size_t len, hash_t hash);
+    StringValue *insert(const char *s, size_t len, hash_t hash);
+    StringValue *update(const char *s, size_t len, hash_t hash);
+
+    void printStats(const char *name);
+
+private:
+    void release();
+};
+
 #endif
@@ -551,5 +551,11 @@ Dsymbol *Scope::search_correct(Identifier *ident)
     if (global.gag)
         return NULL;            // don't do it for speculative compiles; too time consuming
 
-    return (Dsymbol *)speller(ident->toChars(), &scope_search_fp, this, idchars);
+    Speller sp(ident->toChars(), &scope_search_fp, this);
+    for (Scope *sc = this; sc; sc = sc->enclosing)
+    {
+        if (sc->scopesym)
+            sc->scopesym->showSpellings(&sp);
+    }
+    return (Dsymbol *)sp.result();
 }
@@ -332,6 +332,7 @@ unsigned AggregateDeclaration::size(Loc loc)
     //printf("AggregateDeclaration::size() %s, scope = %p\n", toChars(), scope);
     if (loc.linnum == 0)
         loc = this->loc;
+    CtfeRegionSuspend suspend;  // may run semantic on behalf of CTFE
     if (sizeok != SIZEOKdone && scope)
         semantic(NULL);
 
@@ -730,7 +731,7 @@ void StructDeclaration::semantic(Scope *sc)
         return;
     }
     if (!symtab)
-        symtab = new DsymbolTable();
+        symtab = new DsymbolTable(members->dim);
 
     if (sizeok == SIZEOKnone)            // if not already done the addMember step
     {
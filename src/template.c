@@ -35,6 +35,7 @@
 #include "id.h"
 #include "attrib.h"
 #include "tokens.h"
+#include "timetrace.h"
 
 #define LOG     0
 
@@ -457,7 +458,12 @@ TemplateDeclaration::TemplateDeclaration(Loc loc, Identifier *id,
     this->isstatic = true;
     this->previous = NULL;
     this->protection = Prot(PROTundefined);
+    this->insttab = NULL;
+    this->insttabdim = 0;
     this->numinstances = 0;
+    this->numlookups = 0;
+    this->numprobes = 0;
+    this->maxprobes = 0;
 
     // Compute in advance for Ddoc's use
     // Bugzilla 11153: ident could be NULL if parsing fails.
@@ -2634,6 +2640,27 @@ Prot TemplateDeclaration::prot()
     return protection;
 }
 
+/****************************************************
+ * Return slot in TemplateDeclaration::insttab[] where the search
+ * for an instance with hash starts.
+ */
+
+static size_t instanceSlot(hash_t hash, size_t mask)
+{
+    /* The hash is a sum of pointers and small integers, so mix all
+     * its bits into the low ones (MurmurHash3's finalizer).
+     */
+    unsigned long long h = hash;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return (size_t)h & mask;
+}
+
+static TemplateDeclarations *vtemplates;        // templates with instances, for -vtemplates
+
 /****************************************************
  * Given a new instance tithis of this TemplateDeclaration,
  * see if there already exists an instance.
@@ -2645,31 +2672,34 @@ TemplateInstance *TemplateDeclaration::findExistingInstance(TemplateInstance *ti
     tithis->fargs = fargs;
     hash_t hash = tithis->hashCode();
 
-    if (!buckets.dim)
-    {
-        buckets.setDim(7);
-        buckets.zero();
-    }
-    size_t bi = hash % buckets.dim;
-    TemplateInstances *instances = buckets[bi];
-    if (instances)
+    numlookups++;
+    if (!numinstances)
+        return NULL;
+
+    size_t mask = insttabdim - 1;
+    unsigned probes = 0;
+    TemplateInstance *ti = NULL;
+    for (size_t i = instanceSlot(hash, mask); 1; i = (i + 1) & mask)
     {
-        for (size_t i = 0; i < instances->dim; i++)
-        {
-            TemplateInstance *ti = (*instances)[i];
+        TemplateInstanceEntry *e = &insttab[i];
+        probes++;
+        if (!e->ti)
+            break;
 #if LOG
-            printf("\t%s: checking for match with instance %d (%p): '%s'\n", tithis->toChars(), i, ti, ti->toChars());
+        printf("\t%s: checking for match with instance %d (%p): '%s'\n", tithis->toChars(), i, e->ti, e->ti->toChars());
 #endif
-            if (hash == ti->hash &&
-                tithis->compare(ti) == 0)
-            {
-                //printf("hash = %p yes %d n = %d\n", hash, instances->dim, numinstances);
-                return ti;
-            }
+        if (hash == e->hash &&
+            tithis->compare(e->ti) == 0)
+        {
+            //printf("hash = %p yes %d n = %d\n", hash, probes, numinstances);
+            ti = e->ti;
+            break;
         }
     }
-    //printf("hash = %p no\n", hash);
-    return NULL;        // didn't find a match
+    numprobes += probes;
+    if (probes > maxprobes)
+        maxprobes = probes;
+    return ti;
 }
 
 /********************************************
@@ -2679,43 +2709,42 @@ TemplateInstance *TemplateDeclaration::findExistingInstance(TemplateInstance *ti
 
 TemplateInstance *TemplateDeclaration::addInstance(TemplateInstance *ti)
 {
-    /* See if we need to rehash
+    /* Keep the table at most half full, so runs of occupied slots stay short
      */
-    if (numinstances > buckets.dim * 4)
+    if ((numinstances + 1) * 2 > insttabdim)
     {
-        // rehash
-        //printf("rehash\n");
-        size_t newdim = buckets.dim * 2 + 1;
-        TemplateInstances **newp = (TemplateInstances **)::calloc(newdim, sizeof(TemplateInstances *));
-        assert(newp);
-        for (size_t bi = 0; bi < buckets.dim; ++bi)
+        if (!insttabdim && global.params.vtemplates)
+        {
+            if (!vtemplates)
+                vtemplates = new TemplateDeclarations();
+            vtemplates->push(this);
+        }
+
+        size_t newdim = insttabdim ? insttabdim * 2 : 8;
+        TemplateInstanceEntry *newtab = (TemplateInstanceEntry *)mem.calloc(newdim, sizeof(TemplateInstanceEntry));
+        for (size_t i = 0; i < insttabdim; i++)
         {
-            TemplateInstances *instances = buckets[bi];
-            if (instances)
+            TemplateInstanceEntry *e = &insttab[i];
+            if (e->ti)
             {
-                for (size_t i = 0; i < instances->dim; i++)
-                {
-                    TemplateInstance *ti1 = (*instances)[i];
-                    size_t newbi = ti1->hash % newdim;
-                    TemplateInstances *newinstances = newp[newbi];
-                    if (!newinstances)
-                        newp[newbi] = newinstances = new TemplateInstances();
-                    newinstances->push(ti1);
-                }
-                delete instances;
+                size_t j = instanceSlot(e->hash, newdim - 1);
+                while (newtab[j].ti)
+                    j = (j + 1) & (newdim - 1);
+                newtab[j] = *e;
             }
         }
-        buckets.setDim(newdim);
-        memcpy(buckets.tdata(), newp, newdim * sizeof(TemplateInstance *));
-        ::free(newp);
+        mem.free(insttab);
+        insttab = newtab;
+        insttabdim = newdim;
     }
 
     // Insert ti into hash table
-    size_t bi = ti->hash % buckets.dim;
-    TemplateInstances *instances = buckets[bi];
-    if (!instances)
-        buckets[bi] = instances = new TemplateInstances();
-    instances->push(ti);
+    size_t mask = insttabdim - 1;
+    size_t i = instanceSlot(ti->hash, mask);
+    while (insttab[i].ti)
+        i = (i + 1) & mask;
+    insttab[i].hash = ti->hash;
+    insttab[i].ti = ti;
     ++numinstances;
     return ti;
 }
@@ -2728,20 +2757,66 @@ TemplateInstance *TemplateDeclaration::addInstance(TemplateInstance *ti)
 
 void TemplateDeclaration::removeInstance(TemplateInstance *handle)
 {
-    size_t bi = handle->hash % buckets.dim;
-    TemplateInstances *instances = buckets[bi];
-    for (size_t i = 0; i < instances->dim; i++)
+    size_t mask = insttabdim - 1;
+    size_t i = instanceSlot(handle->hash, mask);
+    while (insttab[i].ti != handle)
     {
-        TemplateInstance *ti = (*instances)[i];
-        if (handle == ti)
+        assert(insttab[i].ti);
+        i = (i + 1) & mask;
+    }
+
+    /* Close the gap, moving back later entries of the run that
+     * would otherwise no longer be reachable from their home slot.
+     */
+    for (size_t j = (i + 1) & mask; insttab[j].ti; j = (j + 1) & mask)
+    {
+        size_t home = instanceSlot(insttab[j].hash, mask);
+        if (i <= j ? (home <= i || home > j)
+                   : (home <= i && home > j))
         {
-            instances->remove(i);
-            break;
+            insttab[i] = insttab[j];
+            i = j;
         }
     }
+    insttab[i].hash = 0;
+    insttab[i].ti = NULL;
     --numinstances;
 }
 
+/*******************************************
+ * For -vtemplates, list how often each template got instantiated
+ * and how its table of instances performed, most used first.
+ */
+
+static int vtemplatesCmp(const void *p1, const void *p2)
+{
+    TemplateDeclaration *td1 = *(TemplateDeclaration **)p1;
+    TemplateDeclaration *td2 = *(TemplateDeclaration **)p2;
+    if (td1->numlookups != td2->numlookups)
+        return td1->numlookups < td2->numlookups ? 1 : -1;
+    return 0;
+}
+
+void printTemplateStats()
+{
+    if (!vtemplates)
+        return;
+
+    qsort(vtemplates->tdata(), vtemplates->dim, sizeof(TemplateDeclaration *), &vtemplatesCmp);
+    for (size_t i = 0; i < vtemplates->dim; i++)
+    {
+        TemplateDeclaration *td = (*vtemplates)[i];
+        char *p = td->loc.toChars();
+        fprintf(global.stdmsg, "%s: vtemplate: %u (%u distinct) instantiation(s) of template '%s' found, "
+            "%u slots, %.2f probes per lookup, longest %u\n",
+            p ? p : "", td->numlookups, (unsigned)td->numinstances, td->toPrettyChars(),
+            (unsigned)td->insttabdim, td->numlookups ? (double)td->numprobes / td->numlookups : 0.0,
+            td->maxprobes);
+        if (p)
+            mem.free(p);
+    }
+}
+
 /* ======================== Type ============================================ */
 
 /****
@@ -5787,6 +5862,7 @@ void TemplateInstance::semantic(Scope *sc, Expressions *fargs)
     printf("\ttempdecl %s\n", tempdecl->toChars());
 #endif
     unsigned errorsave = global.errors;
+    TimeTraceScope trace("template instance", this);
 
     inst = this;
     parent = enclosing ? enclosing : tempdecl->parent;
@@ -5899,7 +5975,7 @@ void TemplateInstance::semantic(Scope *sc, Expressions *fargs)
 
     // Add members of template instance to template instance symbol table
 //    parent = scope->scopesym;
-    symtab = new DsymbolTable();
+    symtab = new DsymbolTable(members->dim);
     int memnum = 0;
     for (size_t i = 0; i < members->dim; i++)
     {
@@ -6782,7 +6858,14 @@ bool TemplateInstance::findBestMatch(Scope *sc, Expressions *fargs)
         TemplateDeclaration *tdecl = tempdecl->isTemplateDeclaration();
 
         if (errs != global.errors)
-            errorSupplemental(loc, "while looking for match for %s", toChars());
+        {
+            if (!global.gag)
+                errorSupplemental(loc, "while looking for match for %s", toChars());
+        }
+        else if (global.gagError())
+        {
+            // Nobody will see the message, don't format the declaration
+        }
         else if (tovers)
             error("does not match template overload set %s", tovers->toChars());
         else if (tdecl && !tdecl->overnext)
@@ -7873,7 +7956,7 @@ void TemplateMixin::semantic(Scope *sc)
             symtab = sc->parent->isScopeDsymbol()->symtab;
         L1:
             assert(symtab);
-            int num = (int)dmd_aaLen(symtab->tab) + 1;
+            int num = (int)symtab->tab.length() + 1;
             ident = Identifier::generateId(s, num);
             symtab->insert(this);
         }
@@ -7938,7 +8021,7 @@ void TemplateMixin::semantic(Scope *sc)
     if (!members)
         return;
 
-    symtab = new DsymbolTable();
+    symtab = new DsymbolTable(members->dim);
 
     for (Scope *sce = sc; 1; sce = sce->enclosing)
     {
@@ -57,6 +57,12 @@ struct TemplatePrevious
     Objects *dedargs;
 };
 
+struct TemplateInstanceEntry
+{
+    hash_t hash;                        // ti->hash, saves looking at ti when probing
+    TemplateInstance *ti;               // NULL if slot is empty
+};
+
 class TemplateDeclaration : public ScopeDsymbol
 {
 public:
@@ -65,10 +71,16 @@ public:
     TemplateParameters *origParameters; // originals for Ddoc
     Expression *constraint;
 
-    // Hash table to look up TemplateInstance's of this TemplateDeclaration
-    Array<TemplateInstances *> buckets;
+    // Open addressed hash table to look up TemplateInstance's of this TemplateDeclaration
+    TemplateInstanceEntry *insttab;
+    size_t insttabdim;                  // number of slots in insttab[], a power of 2
     size_t numinstances;                // number of instances in the hash table
 
+    // Counts for -vtemplates
+    unsigned numlookups;                // calls to findExistingInstance()
+    unsigned numprobes;                 // slots examined by them
+    unsigned maxprobes;                 // most slots examined by one of them
+
     TemplateDeclaration *overnext;      // next overloaded TemplateDeclaration
     TemplateDeclaration *overroot;      // first in overnext list
     FuncDeclaration *funcroot;          // first function in unified overload list
@@ -0,0 +1,228 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/timetrace.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "rmem.h"
+#include "root.h"
+#include "port.h"
+
+#include "mars.h"
+#include "dsymbol.h"
+#include "timetrace.h"
+
+struct TimeTraceEvent
+{
+    const char *name;
+    const char *detail;
+    unsigned long long start;           // nanoseconds since timeTraceBegin()
+    unsigned long long duration;
+};
+
+struct TimeTraceTotal
+{
+    const char *name;
+    unsigned long long duration;        // of the outermost spans of name
+    size_t count;                       // of all spans of name
+    unsigned depth;                     // number of open spans of name
+};
+
+static unsigned long long traceStart;
+static Array<TimeTraceEvent> traceEvents;
+static Array<TimeTraceTotal> traceTotals;
+
+/*********************************
+ * Start the clock all spans are relative to.
+ */
+
+void timeTraceBegin()
+{
+    traceStart = Port::nanoseconds();
+}
+
+TimeTraceScope::TimeTraceScope(const char *name, const char *detail)
+{
+    this->name = NULL;
+    if (!global.params.timeTrace)
+        return;
+    this->detail = detail;
+    this->sym = NULL;
+    begin(name);
+}
+
+TimeTraceScope::TimeTraceScope(const char *name, Dsymbol *s)
+{
+    this->name = NULL;
+    if (!global.params.timeTrace)
+        return;
+    this->detail = NULL;
+    this->sym = s;
+    begin(name);
+}
+
+void TimeTraceScope::begin(const char *name)
+{
+    this->name = name;
+
+    // Names are string literals, and there are only a handful of them
+    size_t i;
+    for (i = 0; i < traceTotals.dim; i++)
+    {
+        if (traceTotals[i].name == name)
+            break;
+    }
+    if (i == traceTotals.dim)
+    {
+        TimeTraceTotal t;
+        t.name = name;
+        t.duration = 0;
+        t.count = 0;
+        t.depth = 0;
+        traceTotals.push(t);
+    }
+    itotal = i;
+    traceTotals[i].depth++;
+
+    start = Port::nanoseconds();
+}
+
+TimeTraceScope::~TimeTraceScope()
+{
+    if (!name)
+        return;
+
+    unsigned long long duration = Port::nanoseconds() - start;
+
+    /* Recursive spans of the same name, like nested template
+     * instantiations, only add to the total once.
+     */
+    TimeTraceTotal *t = &traceTotals[itotal];
+    t->count++;
+    if (--t->depth == 0)
+        t->duration += duration;
+
+    if (duration < global.params.timeTraceGranularity * 1000ULL)
+        return;
+
+    TimeTraceEvent e;
+    e.name = name;
+    e.detail = sym ? sym->toPrettyChars() : detail;
+    e.start = start - traceStart;
+    e.duration = duration;
+    traceEvents.push(e);
+}
+
+/*********************************
+ * Write string s to buf as a JSON string.
+ */
+
+static void writeString(OutBuffer *buf, const char *s)
+{
+    buf->writeByte('"');
+    for (; *s; s++)
+    {
+        unsigned char c = *s;
+        switch (c)
+        {
+            case '"':   buf->writestring("\\\"");   break;
+            case '\\':  buf->writestring("\\\\");   break;
+            case '\n':  buf->writestring("\\n");    break;
+            case '\r':  buf->writestring("\\r");    break;
+            case '\t':  buf->writestring("\\t");    break;
+            default:
+                if (c < 0x20)
+                    buf->printf("\\u%04x", c);
+                else
+                    buf->writeByte(c);
+                break;
+        }
+    }
+    buf->writeByte('"');
+}
+
+/*********************************
+ * Write the microseconds in ns to buf.
+ */
+
+static void writeTime(OutBuffer *buf, unsigned long long ns)
+{
+    buf->printf("%llu.%03u", ns / 1000, (unsigned)(ns % 1000));
+}
+
+static int eventCmp(const void *p1, const void *p2)
+{
+    const TimeTraceEvent *e1 = (const TimeTraceEvent *)p1;
+    const TimeTraceEvent *e2 = (const TimeTraceEvent *)p2;
+    // Enclosing spans first
+    if (e1->start != e2->start)
+        return e1->start < e2->start ? -1 : 1;
+    if (e1->duration != e2->duration)
+        return e1->duration > e2->duration ? -1 : 1;
+    return 0;
+}
+
+/*********************************
+ * Write the spans recorded so far, followed by the total time spent
+ * under each name, as a Chrome trace-event file.
+ */
+
+void timeTraceWrite(const char *filename)
+{
+    unsigned long long end = Port::nanoseconds() - traceStart;
+
+    qsort(traceEvents.tdata(), traceEvents.dim, sizeof(TimeTraceEvent), &eventCmp);
+
+    OutBuffer buf;
+    buf.writestring("{\"traceEvents\":[\n");
+    buf.writestring("{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"dmd\"}},\n");
+
+    buf.writestring("{\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":0,\"dur\":");
+    writeTime(&buf, end);
+    buf.writestring(",\"name\":\"dmd\"}");
+
+    for (size_t i = 0; i < traceEvents.dim; i++)
+    {
+        TimeTraceEvent *e = &traceEvents[i];
+        buf.writestring(",\n{\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":");
+        writeTime(&buf, e->start);
+        buf.writestring(",\"dur\":");
+        writeTime(&buf, e->duration);
+        buf.writestring(",\"name\":");
+        writeString(&buf, e->name);
+        if (e->detail)
+        {
+            buf.writestring(",\"args\":{\"detail\":");
+            writeString(&buf, e->detail);
+            buf.writeByte('}');
+        }
+        buf.writeByte('}');
+    }
+
+    // One row per total, so they stack up under each other
+    for (size_t i = 0; i < traceTotals.dim; i++)
+    {
+        TimeTraceTotal *t = &traceTotals[i];
+        buf.printf(",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":0,\"dur\":", (unsigned)(i + 1));
+        writeTime(&buf, t->duration);
+        buf.writestring(",\"name\":\"Total ");
+        buf.writestring(t->name);
+        buf.printf("\",\"args\":{\"count\":%llu}}", (ulonglong)t->count);
+    }
+    buf.writestring("\n]}\n");
+
+    ensurePathToNameExists(Loc(), filename);
+    File f(filename);
+    f.setbuffer(buf.data, buf.offset);
+    f.ref = 1;
+    writeFile(Loc(), &f);
+}
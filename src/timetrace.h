@@ -0,0 +1,51 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/timetrace.h
+ */
+
+#ifndef DMD_TIMETRACE_H
+#define DMD_TIMETRACE_H
+
+#ifdef __DMC__
+#pragma once
+#endif /* __DMC__ */
+
+#include "root.h"
+
+class Dsymbol;
+
+/* Time spent in the phases of the compiler (-ftime-trace), written as a
+ * Chrome trace-event file that can be loaded into chrome://tracing or
+ * https://ui.perfetto.dev.
+ *
+ * A TimeTraceScope records one span, from its construction to its
+ * destruction. Spans shorter than -ftime-trace-granularity are not
+ * written, but still count towards the total of their name. Only the
+ * main thread may open spans.
+ */
+
+struct TimeTraceScope
+{
+    TimeTraceScope(const char *name, const char *detail = NULL);
+    TimeTraceScope(const char *name, Dsymbol *s);
+    ~TimeTraceScope();
+
+private:
+    const char *name;           // NULL if not tracing
+    const char *detail;
+    Dsymbol *sym;               // detail is sym->toPrettyChars(), only computed if the span is written
+    size_t itotal;              // index of total of name
+    unsigned long long start;
+
+    void begin(const char *name);
+};
+
+void timeTraceBegin();
+void timeTraceWrite(const char *filename);
+
+#endif /* DMD_TIMETRACE_H */
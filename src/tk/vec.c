@@ -359,11 +359,19 @@ size_t vec_index(size_t b,vec_t vec)
         starv = *v >> bit;
         while (1)
         {
-                while (starv)
-                {       if (starv & 1)
-                                return b;
-                        b++;
+                if (starv)
+                {
+#if __GNUC__
+                    return b + (sizeof(starv) == sizeof(unsigned long long)
+                                ? __builtin_ctzll(starv)
+                                : __builtin_ctz(starv));
+#else
+                    while (!(starv & 1))
+                    {   b++;
                         starv >>= 1;
+                    }
+                    return b;
+#endif
                 }
                 b = (b + VECBITS) & ~VECMASK;   /* round up to next word */
                 if (++v >= vtop)
@@ -464,30 +472,8 @@ void vec_orass(vec_t v1,vec_t v2)
         assert(vec_numbits(v1)==vec_numbits(v2));
 #endif
         vtop = &v1[vec_dim(v1)];
-#if __INTSIZE == 2 && __I86__ && (__COMPACT__ || __LARGE__ || __VCM__)
-        _asm
-        {
-                push    DS
-                lds     SI,v2
-                les     DI,v1
-                mov     CX,word ptr vtop
-                cmp     CX,DI
-                jz      L1
-            L2: mov     AX,[SI]
-                add     SI,2
-                or      ES:[DI],AX
-                add     DI,2
-                cmp     DI,CX
-                jb      L2
-            L1: pop     DS
-        #if __SC__ <= 0x610
-                jmp     Lret
-        #endif
-        }
-#else
         for (; v1 < vtop; v1++,v2++)
             *v1 |= *v2;
-#endif
     }
     else
         assert(!v2);
@@ -550,6 +536,33 @@ void vec_sub(vec_t v1,vec_t v2,vec_t v3)
         assert(!v2 && !v3);
 }
 
+/********************************
+ * Compute v1 = (v2 - v3) | v4, the transfer function of a block in
+ * the optimizer's dataflow problems, in one pass.
+ * Returns:
+ *      1 if v1 changed
+ */
+
+int vec_subor(vec_t v1,vec_t v2,vec_t v3,vec_t v4)
+{   vec_t vtop;
+    vec_base_t changed = 0;
+
+    if (!v1)
+    {   assert(!v2 && !v3 && !v4);
+        return 0;
+    }
+    assert(v2 && v3 && v4);
+    assert(vec_numbits(v1)==vec_numbits(v2) && vec_numbits(v1)==vec_numbits(v3) &&
+           vec_numbits(v1)==vec_numbits(v4));
+    vtop = &v1[vec_dim(v1)];
+    for (; v1 < vtop; v1++,v2++,v3++,v4++)
+    {   vec_base_t x = (*v2 & ~*v3) | *v4;
+        changed |= x ^ *v1;
+        *v1 = x;
+    }
+    return changed != 0;
+}
+
 /****************
  * Clear vector.
  */
@@ -0,0 +1,583 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/tokcache.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+#if _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "rmem.h"
+#include "root.h"
+#include "aav.h"
+
+#include "mars.h"
+#include "lexer.h"
+#include "identifier.h"
+#include "tokcache.h"
+
+/* A cache file is named after a hash of the source text and of the
+ * compiler that wrote it, and is laid out as:
+ *
+ *      Header
+ *      char[identsize]         nidents 0 terminated identifiers, in order of first use
+ *      ubyte[]                 token records to the end of the file, the last one TOKeof
+ *
+ * A token record is a run of unsigned LEB128 numbers:
+ *
+ *      value << 2 | has identifier << 1 | file changed
+ *      if file changed, 0 for the source file, else 1 + length and the file name
+ *      line number - that of the previous token, zigzag encoded as #line can go back
+ *      charnum
+ *      for integer literals, the value
+ *      for floating point literals, the bytes of float80value instead
+ *      for strings, the postfix, the length and the bytes of the string
+ *      if it has an identifier, its index
+ *
+ * so most tokens take a few bytes, not much more than in the source.
+ *
+ * The file is checked against the hash in the header when it is loaded,
+ * rather than by decoding it all twice.
+ *
+ * Tokens don't depend on version or debug identifiers, which aren't
+ * evaluated until semantic, so they aren't part of the key. Loc's that
+ * refer to the source file itself are stored without the file name, so
+ * the same source text found under another name shares the cache file.
+ */
+
+#define TOKCACHE_VERSION 2
+
+struct Header
+{
+    char magic[8];              // "DTOKENS"
+    unsigned version;           // TOKCACHE_VERSION
+    unsigned sizes;             // layout of Token
+    unsigned numlines;          // Lexer::scanloc.linnum at end of file
+    unsigned ntokens;
+    unsigned nidents;
+    unsigned identsize;
+    unsigned long long check[2]; // hash of the rest of the file
+};
+
+enum
+{
+    CTnone,                     // no payload
+    CTinteger,                  // literal value
+    CTfloat,
+    CTstring,
+};
+
+static int kind(unsigned value)
+{
+    switch (value)
+    {
+        case TOKint32v: case TOKuns32v:
+        case TOKint64v: case TOKuns64v:
+        case TOKcharv: case TOKwcharv: case TOKdcharv:
+            return CTinteger;
+
+        case TOKfloat32v: case TOKfloat64v: case TOKfloat80v:
+        case TOKimaginary32v: case TOKimaginary64v: case TOKimaginary80v:
+            return CTfloat;
+
+        case TOKstring:
+        case TOKxstring:
+            return CTstring;
+
+        default:
+            return CTnone;
+    }
+}
+
+/* A token record, decoded
+ */
+struct CachedToken
+{
+    unsigned value;             // TOK
+    bool newfile;               // file name follows
+    const char *filename;       // if newfile, NULL for the source file
+    size_t filenamelen;
+    unsigned linnum;
+    unsigned charnum;
+    d_uns64 number;             // CTinteger
+    const unsigned char *bytes; // CTfloat, CTstring
+    size_t len;                 // CTstring
+    unsigned char postfix;      // CTstring
+    bool hasident;
+    size_t ident;               // index of identifier
+};
+
+static void writeNumber(OutBuffer *buf, d_uns64 n)
+{
+    while (n >= 0x80)
+    {
+        buf->writeByte((unsigned)(n & 0x7F) | 0x80);
+        n >>= 7;
+    }
+    buf->writeByte((unsigned)n);
+}
+
+/* Returns:
+ *      pointer past the number, NULL if it runs past end or doesn't fit
+ */
+static inline const unsigned char *readNumber(const unsigned char *p, const unsigned char *end, d_uns64 *pn)
+{
+    if (p < end && *p < 0x80)
+    {   // most are
+        *pn = *p;
+        return p + 1;
+    }
+    d_uns64 n = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        unsigned char c = *p++;
+        n |= (d_uns64)(c & 0x7F) << shift;
+        if (!(c & 0x80))
+        {
+            *pn = n;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/************************************
+ * Decode the token record at p, the token after one on line linnum.
+ * Returns:
+ *      the next record, NULL if this one is malformed
+ */
+
+static const unsigned char *decode(const unsigned char *p, const unsigned char *end,
+        unsigned linnum, CachedToken *ct)
+{
+    d_uns64 n;
+    if (!(p = readNumber(p, end, &n)) || (n >> 2) >= TOKMAX)
+        return NULL;
+    ct->value = (unsigned)(n >> 2);
+    ct->hasident = (n & 2) != 0;
+    ct->newfile = (n & 1) != 0;
+    ct->filename = NULL;
+    ct->filenamelen = 0;
+    if (ct->newfile)
+    {
+        if (!(p = readNumber(p, end, &n)) || n > (d_uns64)(end - p) + 1)
+            return NULL;
+        if (n)
+        {
+            ct->filename = (const char *)p;
+            ct->filenamelen = (size_t)n - 1;
+            p += ct->filenamelen;
+        }
+    }
+    if (!(p = readNumber(p, end, &n)))
+        return NULL;
+    ct->linnum = linnum + (unsigned)((n >> 1) ^ (0 - (n & 1)));
+    if (!(p = readNumber(p, end, &n)))
+        return NULL;
+    ct->charnum = (unsigned)n;
+    switch (kind(ct->value))
+    {
+        case CTinteger:
+            if (!(p = readNumber(p, end, &ct->number)))
+                return NULL;
+            break;
+
+        case CTfloat:
+            if ((size_t)(end - p) < sizeof(d_float80))
+                return NULL;
+            ct->bytes = p;
+            p += sizeof(d_float80);
+            break;
+
+        case CTstring:
+            if (p == end)
+                return NULL;
+            ct->postfix = *p++;
+            if (!(p = readNumber(p, end, &n)) || n > (d_uns64)(end - p))
+                return NULL;
+            ct->len = (size_t)n;
+            ct->bytes = p;
+            p += ct->len;
+            break;
+    }
+    if (ct->hasident)
+    {
+        if (!(p = readNumber(p, end, &n)))
+            return NULL;
+        ct->ident = (size_t)n;
+    }
+    return p;
+}
+
+static const char magic[8] = "DTOKENS";
+
+static unsigned layout()
+{
+    return (unsigned)(sizeof(d_float80) << 8 | sizeof(void *) << 16);
+}
+
+/************************************
+ * 128 bit hash of source text, good enough to tell different files
+ * apart but not meant to resist deliberate collisions.
+ */
+
+static inline unsigned long long rotl(unsigned long long x, int n)
+{
+    return (x << n) | (x >> (64 - n));
+}
+
+static inline unsigned long long fmix(unsigned long long h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static void hashBytes(unsigned long long h[2], const void *data, size_t len)
+{
+    const unsigned long long c1 = 0x87C37B91114253D5ULL;
+    const unsigned long long c2 = 0x4CF5AD432745937FULL;
+    const unsigned char *p = (const unsigned char *)data;
+
+    for (; len >= 8; p += 8, len -= 8)
+    {
+        unsigned long long w;
+        memcpy(&w, p, 8);
+        h[0] = rotl(h[0] ^ (rotl(w * c1, 31) * c2), 27) * 5 + 0x52DCE729;
+        h[1] = rotl(h[1] ^ (rotl(w * c2, 33) * c1), 31) * 5 + 0x38495AB5;
+    }
+    unsigned long long w = len;
+    for (size_t i = 0; i < len; i++)
+        w |= (unsigned long long)p[i] << (8 + i * 8);
+    h[0] = fmix(h[0] ^ rotl(w * c1, 31) * c2);
+    h[1] = fmix(h[1] ^ rotl(w * c2, 33) * c1);
+}
+
+/************************************
+ * Look up the cache file for the source text being lexed by lex,
+ * and attach to lex so it gets its tokens from the cache, or
+ * records them for it.
+ */
+
+TokenCache *TokenCache::attach(const char *dir, Lexer *lex)
+{
+    unsigned long long h[2] = { 0, 0 };
+
+    OutBuffer key;
+    key.printf("%s %u %u %u", global.version, TOKCACHE_VERSION, layout(), (unsigned)TOKMAX);
+    hashBytes(h, key.data, key.offset);
+    hashBytes(h, lex->base, lex->end - lex->base);
+
+    OutBuffer name;
+    name.printf("%016llx%016llx.tok", h[0], h[1]);
+    const char *filename = FileName::combine(dir, name.peekString());
+
+    TokenCache *tc = new TokenCache(filename, lex->scanloc.filename);
+    if (!tc->load())
+        tc->recording = true;
+    lex->tokcache = tc;
+    return tc;
+}
+
+TokenCache::TokenCache(const char *filename, const char *srcname)
+{
+    this->filename = filename;
+    this->srcname = srcname;
+    this->errors = global.errors;
+    file = NULL;
+    next = NULL;
+    end = NULL;
+    idents = NULL;
+    nidents = 0;
+    numlines = 0;
+    lastfilename = NULL;
+    linnum = 0;
+    recording = false;
+    eof = false;
+    ntokens = 0;
+    identmap = NULL;
+    lastrecfile = NULL;
+}
+
+/************************************
+ * Read and check cache file.
+ * Returns:
+ *      true if tokens can be replayed from it
+ */
+
+bool TokenCache::load()
+{
+    File *f = new File(filename);
+    if (f->mmread())
+        goto Lerr;
+
+    {
+        Header h;
+        size_t len = f->len;
+        if (len < sizeof(h))
+            goto Lerr;
+        memcpy(&h, f->buffer, sizeof(h));
+        if (memcmp(h.magic, magic, sizeof(magic)) != 0 ||
+            h.version != TOKCACHE_VERSION ||
+            h.sizes != layout() ||
+            h.ntokens == 0 ||
+            h.identsize > len - sizeof(h))
+            goto Lerr;
+
+        // Check the whole file now, so replaying can't fail half way
+        unsigned long long check[2] = { 0, 0 };
+        hashBytes(check, f->buffer + sizeof(h), len - sizeof(h));
+        if (check[0] != h.check[0] || check[1] != h.check[1])
+            goto Lerr;
+
+        const char *identp = (const char *)f->buffer + sizeof(h);
+        const unsigned char *pend = f->buffer + len;
+        if (h.identsize && identp[h.identsize - 1] != 0)
+            goto Lerr;
+
+        // Identifiers are looked up once here instead of at every use
+        idents = (Identifier **)mem.malloc(h.nidents * sizeof(Identifier *));
+        const char *identend = identp + h.identsize;
+        for (size_t i = 0; i < h.nidents; i++)
+        {
+            if (identp == identend)
+                goto Lerr;
+            size_t n = strlen(identp);
+            idents[i] = Identifier::idPool(identp, n);
+            identp += n + 1;
+        }
+
+        file = f;
+        next = (const unsigned char *)identend;
+        end = pend;
+        nidents = h.nidents;
+        numlines = h.numlines;
+        return true;
+    }
+
+Lerr:
+    delete f;
+    return false;
+}
+
+/************************************
+ * Replacement for lex->scan(t).
+ */
+
+void TokenCache::scan(Lexer *lex, Token *t)
+{
+    if (!next)
+    {
+        lex->scan(t);
+        if (recording)
+            record(t);
+        if (t->value == TOKeof)
+            numlines = lex->scanloc.linnum;
+        return;
+    }
+
+    CachedToken ct;
+    const unsigned char *p = decode(next, end, linnum, &ct);
+    assert(p && (!ct.hasident || ct.ident < nidents));
+    if (ct.value == TOKeof)
+        lex->scanloc.linnum = numlines;
+    else
+    {   // TOKeof is replayed for as long as the parser asks
+        next = p;
+        linnum = ct.linnum;
+    }
+
+    if (ct.newfile)
+    {
+        if (ct.filename)
+        {
+            char *s = (char *)mem.malloc(ct.filenamelen + 1);
+            memcpy(s, ct.filename, ct.filenamelen);
+            s[ct.filenamelen] = 0;
+            lastfilename = s;
+        }
+        else
+            lastfilename = NULL;
+    }
+    t->loc.filename = lastfilename ? lastfilename : srcname;
+    t->loc.linnum = ct.linnum;
+    t->loc.charnum = ct.charnum;
+    t->ptr = NULL;
+    t->value = (TOK)ct.value;
+    t->blockComment = NULL;
+    t->lineComment = NULL;
+    switch (kind(ct.value))
+    {
+        case CTinteger:
+            t->uns64value = ct.number;
+            break;
+
+        case CTfloat:
+            memcpy(&t->float80value, ct.bytes, sizeof(t->float80value));
+            break;
+
+        case CTstring:
+            t->ustring = (utf8_t *)mem.malloc(ct.len + 1);
+            memcpy(t->ustring, ct.bytes, ct.len);
+            t->ustring[ct.len] = 0;
+            t->len = (unsigned)ct.len;
+            t->postfix = ct.postfix;
+            break;
+    }
+    if (ct.hasident)
+        t->ident = idents[ct.ident];
+}
+
+/************************************
+ * Append scanned token to the recording.
+ */
+
+void TokenCache::record(Token *t)
+{
+    if (eof)
+        return;                 // Lexer keeps returning TOKeof
+
+    int k = kind(t->value);
+    if (k == CTstring && t->ptr && t->ptr[0] == '_')
+    {
+        /* __DATE__, __TIME__ and friends are replaced by strings
+         * that must not be frozen into the cache.
+         */
+        recording = false;
+        return;
+    }
+
+    // Identifiers and keywords
+    bool hasident = k == CTnone && t->ptr &&
+        (isalpha(t->ptr[0]) || t->ptr[0] == '_' || t->ptr[0] >= 0x80);
+
+    const char *fn = t->loc.filename;
+    if (fn && (fn == srcname || strcmp(fn, srcname) == 0))
+        fn = NULL;
+    bool newfile = fn != lastrecfile && !(fn && lastrecfile && strcmp(fn, lastrecfile) == 0);
+
+    writeNumber(&tokbuf, (d_uns64)t->value << 2 | hasident << 1 | newfile);
+    if (newfile)
+    {
+        lastrecfile = fn;
+        if (fn)
+        {
+            size_t len = strlen(fn);
+            writeNumber(&tokbuf, len + 1);
+            tokbuf.write(fn, len);
+        }
+        else
+            writeNumber(&tokbuf, 0);
+    }
+    int d = (int)(t->loc.linnum - linnum);
+    writeNumber(&tokbuf, (unsigned)(d << 1) ^ (unsigned)(d >> 31));
+    linnum = t->loc.linnum;
+    writeNumber(&tokbuf, t->loc.charnum);
+
+    switch (k)
+    {
+        case CTinteger:
+            writeNumber(&tokbuf, t->uns64value);
+            break;
+
+        case CTfloat:
+            tokbuf.write(&t->float80value, sizeof(t->float80value));
+            break;
+
+        case CTstring:
+            tokbuf.writeByte(t->postfix);
+            writeNumber(&tokbuf, t->len);
+            tokbuf.write(t->ustring, t->len);
+            break;
+    }
+
+    if (hasident)
+    {
+        size_t *pi = (size_t *)dmd_aaGet(&identmap, t->ident);
+        if (!*pi)
+        {
+            identbuf.writestring(t->ident->toChars());
+            identbuf.writeByte(0);
+            *pi = ++nidents;
+        }
+        writeNumber(&tokbuf, *pi - 1);
+    }
+    ntokens++;
+    if (t->value == TOKeof)
+        eof = true;
+}
+
+/************************************
+ * Detach from lex, and save the recorded tokens if the whole file was
+ * lexed without errors.
+ */
+
+void TokenCache::detach(Lexer *lex)
+{
+    lex->tokcache = NULL;
+    if (file)
+    {
+        file->freeBuffer();
+        delete file;
+        file = NULL;
+        next = NULL;
+        end = NULL;
+    }
+    if (recording && eof && !lex->errors && global.errors == errors)
+        save();
+    recording = false;
+}
+
+void TokenCache::save()
+{
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, sizeof(magic));
+    h.version = TOKCACHE_VERSION;
+    h.sizes = layout();
+    h.numlines = numlines;
+    h.ntokens = ntokens;
+    h.nidents = nidents;
+    h.identsize = (unsigned)identbuf.offset;
+
+    OutBuffer buf;
+    buf.reserve(sizeof(h) + identbuf.offset + tokbuf.offset);
+    buf.write(&h, sizeof(h));
+    buf.write(&identbuf);
+    buf.write(&tokbuf);
+    hashBytes(h.check, buf.data + sizeof(h), buf.offset - sizeof(h));
+    memcpy(buf.data, &h, sizeof(h));
+
+    /* Write to a temporary file and rename it, so concurrent
+     * compilations never see a partially written cache file.
+     */
+    const char *path = FileName::path(filename);
+    if (FileName::ensurePathExists(path))
+        return;
+
+    OutBuffer tmpname;
+    tmpname.printf("%s.%d", filename, (int)getpid());
+    File f(tmpname.peekString());
+    f.setbuffer(buf.data, buf.offset);
+    f.ref = 1;
+    if (f.write())
+        return;
+    if (rename(f.name->toChars(), filename) != 0)
+        f.remove();
+}
@@ -0,0 +1,69 @@
+/* Compiler implementation of the D programming language
+ * Copyright (c) 1999-2014 by Digital Mars
+ * All Rights Reserved
+ * written by Walter Bright
+ * http://www.digitalmars.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * http://www.boost.org/LICENSE_1_0.txt
+ * https://github.com/D-Programming-Language/dmd/blob/master/src/tokcache.h
+ */
+
+#ifndef DMD_TOKCACHE_H
+#define DMD_TOKCACHE_H
+
+#ifdef __DMC__
+#pragma once
+#endif /* __DMC__ */
+
+#include "root.h"
+
+class Lexer;
+class Identifier;
+struct Token;
+struct AA;
+
+/* On-disk cache of the tokens of source files (-tokcache=dir), keyed
+ * by a hash of the source text. Attached to a Lexer, it either replays
+ * the tokens found in the cache, or records the tokens the Lexer scans
+ * so they can be saved for the next compilation.
+ */
+
+struct TokenCache
+{
+    const char *filename;       // name of cache file
+    const char *srcname;        // name of source file, as used in Loc's
+    unsigned errors;            // global.errors when attached
+
+    // Replaying
+    File *file;                 // cache file being replayed
+    const unsigned char *next;  // next token record to replay
+    const unsigned char *end;   // end of token records
+    Identifier **idents;        // identifiers used by tokens
+    unsigned nidents;
+    unsigned numlines;          // number of lines in source file
+    const char *lastfilename;   // file name of last token replayed
+
+    // Replaying and recording
+    unsigned linnum;            // line of last token
+
+    // Recording
+    bool recording;             // tokens are cacheable so far
+    bool eof;                   // TOKeof was recorded
+    unsigned ntokens;
+    OutBuffer tokbuf;           // token records
+    OutBuffer identbuf;         // 0 terminated identifiers
+    AA *identmap;               // Identifier* => 1 + index of identifier
+    const char *lastrecfile;    // file name of last token recorded, NULL for source file
+
+    static TokenCache *attach(const char *dir, Lexer *lex);
+    void scan(Lexer *lex, Token *t);
+    void detach(Lexer *lex);
+
+private:
+    TokenCache(const char *filename, const char *srcname);
+    bool load();
+    void record(Token *t);
+    void save();
+};
+
+#endif /* DMD_TOKCACHE_H */
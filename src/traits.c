@@ -1228,7 +1228,10 @@ Expression *semanticTraits(TraitsExp *e, Scope *sc)
     }
     else
     {
-        if (const char *sub = (const char *)speller(e->ident->toChars(), &trait_search_fp, NULL, idchars))
+        Speller sp(e->ident->toChars(), &trait_search_fp, NULL);
+        for (size_t i = 0; traits[i]; i++)
+            sp.check(traits[i]);
+        if (const char *sub = (const char *)sp.result())
             e->error("unrecognized trait '%s', did you mean '%s'?", e->ident->toChars(), sub);
         else
             e->error("unrecognized trait '%s'", e->ident->toChars());
@@ -0,0 +1,4 @@
+#!/usr/bin/env bash
+grep 'depsfile (.*depsfile.d) : private : imports.b33a' ${RESULTS_DIR}/compilable/depsfile.deps || exit 1
+rm -f ${RESULTS_DIR}/compilable/depsfile.deps
+exit 0
@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+
+# Each span is written on a line of its own
+trace=${RESULTS_DIR}/compilable/ftimetrace.json
+
+for span in \
+    '"name":"dmd"' \
+    '"name":"read","args":{"detail":"compilable/ftimetrace.d"}' \
+    '"name":"parse","args":{"detail":"compilable/ftimetrace.d"}' \
+    '"name":"importAll","args":{"detail":"ftimetrace"}' \
+    '"name":"semantic1","args":{"detail":"ftimetrace"}' \
+    '"name":"semantic2","args":{"detail":"ftimetrace"}' \
+    '"name":"semantic3","args":{"detail":"ftimetrace"}' \
+    '"name":"ctfe","args":{"detail":"ftimetrace.fib"}' \
+    '"name":"template instance","args":{"detail":"ftimetrace.twice!int"}' \
+    '"name":"codegen","args":{"detail":"ftimetrace"}' \
+    '"name":"codegen function","args":{"detail":"ftimetrace.foo"}' \
+    '"name":"Total ctfe","args":{"count":177}'
+do
+    grep -qF "${span}" ${trace} || { echo "missing ${span}"; exit 1; }
+done
+
+rm ${trace}
@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+
+# -j only spreads code generation over processes when each module gets its own object file
+dir=${RESULTS_DIR}/compilable/paralleljobs
+rm -rf ${dir}
+mkdir -p ${dir} || exit 1
+
+$DMD -m${MODEL} -Icompilable -c -j=2 -od${dir} compilable/paralleljobs.d \
+    compilable/imports/paralleljobsa.d compilable/imports/paralleljobsb.d || exit 1
+
+for m in paralleljobs paralleljobsa paralleljobsb; do
+    [ -f ${dir}/${m}${OBJ} ] || exit 1
+done
+
+rm -rf ${dir}
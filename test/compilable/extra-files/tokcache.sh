@@ -0,0 +1,13 @@
+#!/usr/bin/env bash
+
+# Compile again from the cache filled in by the test itself, and compare
+# with what the compiler makes of the source without it
+dir=${RESULTS_DIR}/compilable/tokcache
+
+ls ${dir}/*.tok > /dev/null || exit 1
+
+$DMD -m${MODEL} -o- -tokcache=${dir} -X -Xf${dir}/cached.json compilable/tokcache.d || exit 1
+$DMD -m${MODEL} -o- -X -Xf${dir}/lexed.json compilable/tokcache.d || exit 1
+diff ${dir}/cached.json ${dir}/lexed.json || exit 1
+
+rm -rf ${dir}
@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+
+# Times vary and decide the order, so drop them and sort
+output=${RESULTS_DIR}/compilable/vctfe.out
+
+$DMD -m${MODEL} -o- -vctfe compilable/vctfe.d | sed 's/, [0-9.]* ms ([0-9.]* ms self)//' | LC_ALL=C sort > ${output} || exit 1
+diff --strip-trailing-cr compilable/extra-files/vctfe.out ${output} || exit 1
+
+rm ${output}
@@ -0,0 +1,10 @@
+#!/usr/bin/env bash
+
+# How many slots get probed depends on addresses, so only
+# compare the instantiation counts
+output=${RESULTS_DIR}/compilable/vtemplates.out
+
+$DMD -m${MODEL} -o- -vtemplates compilable/vtemplates.d | sed 's/ found, .*/ found/' > ${output} || exit 1
+diff --strip-trailing-cr compilable/extra-files/vtemplates.out ${output} || exit 1
+
+rm ${output}